@@ -0,0 +1,76 @@
+#!/usr/bin/env bash
+
+# Generate a ladder of instances with boxgen, solve each with boxsplit at
+# several thread counts, and write one CSV line per run.
+#
+# Usage: benchmark.sh BOXSPLIT BOXGEN OUTDIR
+#
+# The ladder can be changed through the environment:
+#   BENCH_THREADS     thread counts, the first is the baseline for scaling
+#                     (default "1 2 4")
+#   BENCH_KNAPSACK    knapsack sizes (default "10 20 30")
+#   BENCH_ASSIGNMENT  assignment sizes (default "5 7 9")
+#   BENCH_SETCOVER    set covering sizes (default "10 20 30")
+#                     (set any of the size lists empty to skip that type)
+#   BENCH_CORRELATION objective correlations (default "0")
+#   BENCH_SEED        random seed (default 1)
+#   BENCH_OPTS        further options for boxsplit
+#
+# Results go to OUTDIR/benchmark.csv with the columns
+#   type,size,correlation,seed,threads,elapsed,ips,ips_per_second,speedup,efficiency
+# where speedup is the baseline's elapsed time over this run's, and
+# efficiency is speedup divided by threads over the baseline's threads.
+
+EXECUTABLE=$1
+GENERATOR=$2
+OUTDIR=$3
+THREADS=${BENCH_THREADS:-1 2 4}
+SEED=${BENCH_SEED:-1}
+mkdir -p ${OUTDIR}
+RESULTS=${OUTDIR}/benchmark.csv
+echo "type,size,correlation,seed,threads,elapsed,ips,ips_per_second,speedup,efficiency" > ${RESULTS}
+
+run() {
+  TYPE=$1
+  SIZE=$2
+  CORRELATION=$3
+  INSTANCE=${OUTDIR}/${TYPE}-${SIZE}-${CORRELATION}-${SEED}.lp
+  ${GENERATOR} --type ${TYPE} -n ${SIZE} --correlation ${CORRELATION} \
+    --seed ${SEED} -o ${INSTANCE} || return 1
+  BASE_ELAPSED=""
+  BASE_THREADS=""
+  for T in ${THREADS}; do
+    OUTFILE=${INSTANCE%.lp}-t${T}.out
+    ${EXECUTABLE} -p ${INSTANCE} -o ${OUTFILE} -t ${T} ${BENCH_OPTS} || return 1
+    ELAPSED=$(awk '/elapsed seconds/ {print $1}' ${OUTFILE})
+    IPS=$(awk '/IPs solved/ {print $1}' ${OUTFILE})
+    if [ -z "${BASE_ELAPSED}" ]; then
+      BASE_ELAPSED=${ELAPSED}
+      BASE_THREADS=${T}
+    fi
+    awk -v type=${TYPE} -v size=${SIZE} -v corr=${CORRELATION} \
+        -v seed=${SEED} -v t=${T} -v e=${ELAPSED} -v ips=${IPS} \
+        -v be=${BASE_ELAPSED} -v bt=${BASE_THREADS} 'BEGIN {
+      rate = (e > 0) ? ips / e : 0
+      speedup = (e > 0) ? be / e : 0
+      printf "%s,%d,%s,%d,%d,%.3f,%d,%.1f,%.3f,%.3f\n", type, size, corr,
+        seed, t, e, ips, rate, speedup, speedup * bt / t
+    }' >> ${RESULTS}
+    tail -n 1 ${RESULTS}
+  done
+}
+
+RES=0
+for CORRELATION in ${BENCH_CORRELATION:-0}; do
+  for SIZE in ${BENCH_KNAPSACK-10 20 30}; do
+    run knapsack ${SIZE} ${CORRELATION} || RES=1
+  done
+  for SIZE in ${BENCH_ASSIGNMENT-5 7 9}; do
+    run assignment ${SIZE} ${CORRELATION} || RES=1
+  done
+  for SIZE in ${BENCH_SETCOVER-10 20 30}; do
+    run setcover ${SIZE} ${CORRELATION} || RES=1
+  done
+done
+echo "Results written to ${RESULTS}"
+exit ${RES}
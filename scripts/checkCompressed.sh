@@ -0,0 +1,16 @@
+#!/usr/bin/env bash
+
+# Solve a gzipped copy of TEST, and check that it finds the right points.
+
+EXECUTABLE=$1
+TEST=$2
+TESTNAME=$(basename ${TEST} .lp)
+TESTDIR=$(dirname ${TEST})
+OUTFILE=$(mktemp ${TESTNAME}.XXX)
+COMPRESSED=$(mktemp ${TESTNAME}.XXX).lp.gz
+gzip -c ${TEST} > ${COMPRESSED}
+${EXECUTABLE} -p ${COMPRESSED} -o ${OUTFILE}
+diff -w -I 'seconds\|solved\|Using' ${TESTDIR}/${TESTNAME}.out ${OUTFILE}
+RES=$?
+rm -f ${OUTFILE} ${COMPRESSED} ${COMPRESSED%.lp.gz}
+exit ${RES}
@@ -0,0 +1,28 @@
+#!/usr/bin/env bash
+
+# Solve TEST with a coordinator that has no threads of its own, and two
+# worker processes that connect to it over a Unix domain socket. One worker
+# makes two connections, so that two boxes are solved in the same process.
+
+EXECUTABLE=$1
+TEST=$2
+TESTNAME=$(basename ${TEST} .lp)
+TESTDIR=$(dirname ${TEST})
+OUTFILE=$(mktemp ${TESTNAME}.XXX)
+SOCKET=$(mktemp -u ${TESTNAME}.sock.XXX)
+${EXECUTABLE} -p ${TEST} -o ${OUTFILE} -t 0 --listen unix:${SOCKET} &
+COORDINATOR=$!
+for i in $(seq 1 100); do
+  if [ -S ${SOCKET} ]; then
+    break
+  fi
+  sleep 0.1
+done
+${EXECUTABLE} -p ${TEST} --connect unix:${SOCKET} &
+${EXECUTABLE} -p ${TEST} --connect unix:${SOCKET} -t 2 &
+wait ${COORDINATOR}
+wait
+diff -w -I 'seconds\|solved\|Using' ${TESTDIR}/${TESTNAME}.out ${OUTFILE}
+RES=$?
+rm -f ${OUTFILE} ${SOCKET}
+exit ${RES}
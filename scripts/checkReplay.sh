@@ -0,0 +1,18 @@
+#!/usr/bin/env bash
+
+# Solve TEST while recording the answer to every box, then replay the
+# recording with several threads, and check that both find the right points.
+
+EXECUTABLE=$1
+TEST=$2
+TESTNAME=$(basename ${TEST} .lp)
+TESTDIR=$(dirname ${TEST})
+OUTFILE=$(mktemp ${TESTNAME}.XXX)
+RECORDING=$(mktemp ${TESTNAME}.rec.XXX)
+${EXECUTABLE} -p ${TEST} -o ${OUTFILE} --record ${RECORDING}
+diff -w -I 'seconds\|solved\|Using' ${TESTDIR}/${TESTNAME}.out ${OUTFILE}
+RES=$?
+${EXECUTABLE} --replay ${RECORDING} -o ${OUTFILE} -t 4
+diff -w -I 'seconds\|solved\|Using' ${TESTDIR}/${TESTNAME}.out ${OUTFILE} || RES=1
+rm -f ${OUTFILE} ${RECORDING}
+exit ${RES}
@@ -0,0 +1,29 @@
+#!/usr/bin/env bash
+
+# Solve TEST while writing a checkpoint after every step, and keep the first
+# checkpoint written, which still has boxes waiting or being solved. Then
+# resume from that checkpoint, and check that both runs find the right
+# points.
+
+EXECUTABLE=$1
+TEST=$2
+TESTNAME=$(basename ${TEST} .lp)
+TESTDIR=$(dirname ${TEST})
+OUTFILE=$(mktemp ${TESTNAME}.XXX)
+CHECKPOINT=$(mktemp -u ${TESTNAME}.ckpt.XXX)
+EARLY=$(mktemp ${TESTNAME}.early.XXX)
+${EXECUTABLE} -p ${TEST} -o ${OUTFILE} -t 2 --checkpoint ${CHECKPOINT} \
+  --checkpoint-interval 0 &
+RUN=$!
+# Checkpoints are renamed into place, so a copy is always a whole one.
+while [ ! -f ${CHECKPOINT} ] && kill -0 ${RUN} 2> /dev/null; do
+  sleep 0.01
+done
+cp ${CHECKPOINT} ${EARLY}
+wait ${RUN}
+diff -w -I 'seconds\|solved\|Using' ${TESTDIR}/${TESTNAME}.out ${OUTFILE}
+RES=$?
+${EXECUTABLE} -p ${TEST} -o ${OUTFILE} -t 2 --resume ${EARLY}
+diff -w -I 'seconds\|solved\|Using' ${TESTDIR}/${TESTNAME}.out ${OUTFILE} || RES=1
+rm -f ${OUTFILE} ${CHECKPOINT} ${CHECKPOINT}.tmp ${EARLY}
+exit ${RES}
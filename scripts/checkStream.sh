@@ -0,0 +1,20 @@
+#!/usr/bin/env bash
+
+# Solve TEST while streaming points to a file, and check that the stream
+# has one line for each point in the output file.
+
+EXECUTABLE=$1
+TEST=$2
+TESTNAME=$(basename ${TEST} .lp)
+TESTDIR=$(dirname ${TEST})
+OUTFILE=$(mktemp ${TESTNAME}.XXX)
+STREAM=$(mktemp ${TESTNAME}.stream.XXX)
+${EXECUTABLE} -p ${TEST} -o ${OUTFILE} -t 2 --stream ${STREAM}
+diff -w -I 'seconds\|solved\|Using' ${TESTDIR}/${TESTNAME}.out ${OUTFILE}
+RES=$?
+# Points are the only lines of the output file with tabs in them. Each
+# stream line has the elapsed seconds and IPs solved before the point.
+diff <(grep $'\t' ${OUTFILE} | sort) \
+  <(grep -v '^#' ${STREAM} | cut -f 3- | sort) || RES=1
+rm -f ${OUTFILE} ${STREAM}
+exit ${RES}
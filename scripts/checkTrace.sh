@@ -0,0 +1,16 @@
+#!/usr/bin/env bash
+
+# Solve TEST while tracing, and check that the trace is valid JSON.
+
+EXECUTABLE=$1
+TEST=$2
+TESTNAME=$(basename ${TEST} .lp)
+TESTDIR=$(dirname ${TEST})
+OUTFILE=$(mktemp ${TESTNAME}.XXX)
+TRACE=$(mktemp ${TESTNAME}.trace.XXX)
+${EXECUTABLE} -p ${TEST} -o ${OUTFILE} -t 2 --trace ${TRACE}
+diff -w -I 'seconds\|solved\|Using' ${TESTDIR}/${TESTNAME}.out ${OUTFILE}
+RES=$?
+python3 -m json.tool ${TRACE} > /dev/null || RES=1
+rm -f ${OUTFILE} ${TRACE}
+exit ${RES}
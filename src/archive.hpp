@@ -0,0 +1,185 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+#ifndef ARCHIVE_HPP
+#define ARCHIVE_HPP
+
+#include <array>
+#include <limits>
+#include <list>
+#include <map>
+#include <vector>
+
+#include <ilcplex/cplexx.h>
+
+#include "box.hpp"
+#include "result.hpp"
+#include "sense.hpp"
+
+/**
+ * The nondominated points found so far, for a problem with N objectives.
+ *
+ * Points are kept in a map ordered lexicographically by their objective
+ * values, so inserting a point or looking one up takes O(log n) time, and a
+ * point that is already known is rejected on insertion. Finding the points
+ * on the edge of a box walks the levels of the first objective up to the
+ * box's bound, and skips the rest of a level once its second objective is
+ * past the bound. That prunes most points in practice, but in the worst case
+ * every point is visited.
+ */
+template<int N>
+class Archive {
+  public:
+    explicit Archive(Sense sense) : sense_(sense) { }
+
+    /**
+     * Add r to the archive, which then owns it. Returns false, and does not
+     * take r, if a point with the same objective values is already known.
+     */
+    bool insert(Result<N> * r);
+
+    /**
+     * Whether a point with objective values p is known.
+     */
+    bool contains(const CPXLONG p[]) const;
+
+    /**
+     * Append to out every known point that lies on the edge of b: on its
+     * bound u in exactly one objective, and strictly inside b in every
+     * other. No known point lies strictly inside a box that is still live,
+     * as the box would have been split, so these are the nearest known
+     * points to b. They include the points whose values gave b its bounds.
+     */
+    void bordering(const Box<N> * b, std::vector<Result<N> *> & out) const;
+
+    size_t size() const { return points_.size(); }
+
+    /**
+     * Append every known point to out, smallest first. The archive keeps
+     * them.
+     */
+    void all(std::vector<Result<N> *> & out) const;
+
+    /**
+     * Remove every point from the archive and return them, largest first.
+     */
+    std::list<Result<N> *> take();
+
+  private:
+    typedef std::array<CPXLONG, N> Key;
+
+    static Key key(const CPXLONG p[]);
+
+    /**
+     * Whether p is on the edge of b, as described for bordering().
+     */
+    bool borders(const Box<N> * b, const Key & p) const;
+
+    Sense sense_;
+    std::map<Key, Result<N> *> points_;
+};
+
+template<int N>
+inline typename Archive<N>::Key Archive<N>::key(const CPXLONG p[]) {
+  Key k;
+  for(int i = 0; i < N; ++i) {
+    k[i] = p[i];
+  }
+  return k;
+}
+
+template<int N>
+inline bool Archive<N>::insert(Result<N> * r) {
+  return points_.emplace(key(r->soln), r).second;
+}
+
+template<int N>
+inline bool Archive<N>::contains(const CPXLONG p[]) const {
+  return points_.find(key(p)) != points_.end();
+}
+
+template<int N>
+inline bool Archive<N>::borders(const Box<N> * b, const Key & p) const {
+  int edges = 0;
+  for(int i = 0; i < N; ++i) {
+    if (p[i] == b->u[i]) {
+      edges += 1;
+    } else if ((sense_ == MIN) ? (p[i] > b->u[i]) : (p[i] < b->u[i])) {
+      return false;
+    }
+  }
+  return edges == 1;
+}
+
+template<int N>
+inline void Archive<N>::bordering(const Box<N> * b,
+    std::vector<Result<N> *> & out) const {
+  const CPXLONG highest = std::numeric_limits<CPXLONG>::max();
+  const CPXLONG lowest = std::numeric_limits<CPXLONG>::min();
+  Key from;
+  if (sense_ == MIN) {
+    // Points with p[0] <= u[0] come first.
+    auto it = points_.begin();
+    while ((it != points_.end()) && (it->first[0] <= b->u[0])) {
+      if (N > 1 && it->first[1] > b->u[1]) {
+        // Nothing else at this level of p[0] borders b.
+        from.fill(highest);
+        from[0] = it->first[0];
+        it = points_.upper_bound(from);
+        continue;
+      }
+      if (borders(b, it->first)) {
+        out.push_back(it->second);
+      }
+      ++it;
+    }
+  } else {
+    // Points with p[0] >= u[0] come last.
+    from.fill(lowest);
+    from[0] = b->u[0];
+    auto it = points_.lower_bound(from);
+    while (it != points_.end()) {
+      if (N > 1 && it->first[1] < b->u[1]) {
+        // Skip to the points at this level of p[0] with p[1] >= u[1].
+        from.fill(lowest);
+        from[0] = it->first[0];
+        from[1] = b->u[1];
+        it = points_.lower_bound(from);
+        continue;
+      }
+      if (borders(b, it->first)) {
+        out.push_back(it->second);
+      }
+      ++it;
+    }
+  }
+}
+
+template<int N>
+inline void Archive<N>::all(std::vector<Result<N> *> & out) const {
+  for(auto & entry: points_) {
+    out.push_back(entry.second);
+  }
+}
+
+template<int N>
+inline std::list<Result<N> *> Archive<N>::take() {
+  std::list<Result<N> *> all;
+  for(auto it = points_.rbegin(); it != points_.rend(); ++it) {
+    all.push_back(it->second);
+  }
+  points_.clear();
+  return all;
+}
+
+#endif /* ARCHIVE_HPP */
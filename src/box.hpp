@@ -14,55 +14,107 @@ You should have received a copy of the GNU General Public License along with thi
 #ifndef BOX_HPP
 #define BOX_HPP
 
+#include <atomic>
 #include <string>
 #include <sstream>
 #include <ilcplex/cplexx.h>
 
+#include "pool.hpp"
+
+template<int N> struct IndexNode;
+
+/**
+ * A box in objective space, for a problem with N objectives.
+ */
+template<int N>
 struct Box {
   Box(Box * old);
-  Box(CPXLONG u_[], CPXLONG v_[]);
-  bool less_than_u(CPXLONG a[]);
-  bool greater_than_u(CPXLONG a[]);
+  Box(const CPXLONG u_[], const CPXLONG v_[]);
+  bool less_than_u(const CPXLONG a[]) const;
+  bool greater_than_u(const CPXLONG a[]) const;
   std::string str() const;
 
-  CPXLONG u[3];
-  CPXLONG v[3];
-  // done marks whether we can delete this box
-  bool done;
+  // Boxes come from a Pool rather than the global allocator.
+  static void * operator new(size_t size);
+  static void operator delete(void * p);
+
+  CPXLONG u[N];
+  CPXLONG v[N];
+  // done marks whether we can delete this box. It is set by the JobServer's
+  // coordinator and read by workers, so they can skip boxes that were split
+  // after being handed out.
+  std::atomic<bool> done;
+  // How many times the first box was split to make this one.
+  int depth;
+  // Set to nonzero to interrupt a solve of this box that is in progress.
+  // CPLEX polls this while solving (see Session::watch).
+  volatile int abort;
+  // The BoxIndex leaf holding this box, and its position in that leaf.
+  // leaf is nullptr if the box is not in an index.
+  IndexNode<N> * leaf;
+  size_t slot;
 };
 
-inline Box::Box(Box * old) : done(false) {
-  for(int i = 0; i < 3; ++i) {
+template<int N>
+inline Box<N>::Box(Box * old) : done(false), depth(old->depth + 1),
+    abort(0), leaf(nullptr), slot(0) {
+  for(int i = 0; i < N; ++i) {
     u[i] = old->u[i];
     v[i] = old->v[i];
   }
 }
 
-inline Box::Box(CPXLONG u_[], CPXLONG v_[]) : done(false) {
-  for(int i = 0; i < 3; ++i) {
+template<int N>
+inline Box<N>::Box(const CPXLONG u_[], const CPXLONG v_[]) : done(false),
+    depth(0), abort(0), leaf(nullptr), slot(0) {
+  for(int i = 0; i < N; ++i) {
     u[i] = u_[i];
     v[i] = v_[i];
   }
 }
 
-inline bool Box::less_than_u(CPXLONG a[]) {
-  if ((a[0] < u[0]) && (a[1] < u[1]) && (a[2] < u[2])) {
-    return true;
+template<int N>
+inline void * Box<N>::operator new(size_t) {
+  return Pool<Box<N>>::instance().allocate();
+}
+
+template<int N>
+inline void Box<N>::operator delete(void * p) {
+  Pool<Box<N>>::instance().deallocate(p);
+}
+
+// The comparisons below use & rather than && so that they compile to
+// straight-line code with no branches.
+template<int N>
+inline bool Box<N>::less_than_u(const CPXLONG a[]) const {
+  bool res = true;
+  for(int i = 0; i < N; ++i) {
+    res &= (a[i] < u[i]);
   }
-  return false;
+  return res;
 }
 
-inline bool Box::greater_than_u(CPXLONG a[]) {
-  if ((a[0] > u[0]) && (a[1] > u[1]) && (a[2] > u[2])) {
-    return true;
+template<int N>
+inline bool Box<N>::greater_than_u(const CPXLONG a[]) const {
+  bool res = true;
+  for(int i = 0; i < N; ++i) {
+    res &= (a[i] > u[i]);
   }
-  return false;
+  return res;
 }
 
-inline std::string Box::str() const {
+template<int N>
+inline std::string Box<N>::str() const {
   std::stringstream ss;
-  ss << "Box: [u: " << u[0] << ", " << u[1] << ", " << u[2];
-  ss << ", v: " << v[0] << ", " << v[1] << ", " << v[2] << "]";
+  ss << "Box: [u: " << u[0];
+  for(int i = 1; i < N; ++i) {
+    ss << ", " << u[i];
+  }
+  ss << ", v: " << v[0];
+  for(int i = 1; i < N; ++i) {
+    ss << ", " << v[i];
+  }
+  ss << "]";
   return ss.str();
 }
 
@@ -17,48 +17,100 @@ You should have received a copy of the GNU General Public License along with thi
 #include <atomic>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include <ilcplex/cplexx.h>
 
 #include "sense.hpp"
 #include "task.hpp"
-
-class JobServer;
-class Box;
-
+#include "trace.hpp"
+
+template<int N> class JobServer;
+template<int N> struct Box;
+template<int N> class Result;
+class Solver;
+
+/**
+ * Finds a nondominated point in a box, or shows that there is none, for a
+ * problem with N objectives.
+ */
+template<int N>
 class BoxFinder: public Task {
   public:
-    BoxFinder(std::string problemName, int objCount, Sense sense,
-        JobServer *taskServer, Box * box, CPXLONG * utopia);
-    ~BoxFinder();
+    BoxFinder(std::string problemName, Sense sense,
+        JobServer<N> *taskServer, Solver & solver, Box<N> * box,
+        std::vector<Result<N> *> known, bool keepSolution, bool harvestPool,
+        TraceBuffer * trace = nullptr);
 
     void addNextLevel(Task * nextLevel);
-    Result * operator()() override;
+    Result<N> * operator()();
+
+    /**
+     * How many IPs this finder has solved.
+     */
+    int solved() const;
 
     std::string str() const override;
     std::string details() const override;
 
   private:
     /**
-     * The utopia point for this box.
+     * Look through the CPLEX solution pool for other points inside box_ that
+     * are not dominated by res or each other, verify that they are
+     * nondominated, and attach those that are to res.
+     */
+    void harvestPool(Result<N> * res);
+
+    Box<N> * box_;
+
+    /**
+     * The worker's solver, reused across boxes.
+     */
+    Solver & solver_;
+
+    /**
+     * Known solutions on the edge of box_, used to warm-start the solve.
      */
-    CPXLONG * utopia_;
-    Box * box_;
+    std::vector<Result<N> *> known_;
 
-    JobServer * taskServer_;
+    /**
+     * Whether to store the decision vector in the Result, so that it can
+     * warm-start later boxes.
+     */
+    bool keepSolution_;
+
+    /**
+     * Whether to look for further points in the solution pool.
+     */
+    bool harvestPool_;
+
+    JobServer<N> * taskServer_;
+
+    /**
+     * Where to record how long each step takes, or nullptr.
+     */
+    TraceBuffer * trace_;
+    /**
+     * How many IPs have been solved, counted here as well as in ipcount so
+     * that callers sharing ipcount can tell whose they were.
+     */
+    int solved_;
 };
 
-inline BoxFinder::BoxFinder(std::string problemName, int objCount,
-    Sense sense, JobServer *taskServer, Box * box, CPXLONG * utopia) :
-    Task(problemName, objCount, sense), box_(box), taskServer_(taskServer) {
-    utopia_ = new CPXLONG[objCount_];
-    for(int i = 0; i < objCount_; ++i) {
-      utopia_[i] = utopia[i];
-    }
+template<int N>
+inline BoxFinder<N>::BoxFinder(std::string problemName, Sense sense,
+    JobServer<N> *taskServer, Solver & solver, Box<N> * box,
+    std::vector<Result<N> *> known, bool keepSolution, bool harvestPool,
+    TraceBuffer * trace) :
+    Task(problemName, N, sense), box_(box), solver_(solver),
+    known_(std::move(known)), keepSolution_(keepSolution),
+    harvestPool_(harvestPool), taskServer_(taskServer), trace_(trace),
+    solved_(0) {
 }
 
-inline BoxFinder::~BoxFinder() {
-    delete[] utopia_;
+template<int N>
+inline int BoxFinder<N>::solved() const {
+  return solved_;
 }
 
 #endif /* BOXFINDER_HPP */
@@ -0,0 +1,373 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+#ifndef BOXINDEX_HPP
+#define BOXINDEX_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <ilcplex/cplexx.h>
+
+#include "box.hpp"
+#include "dominance.hpp"
+#include "sense.hpp"
+
+/**
+ * A node of a BoxIndex. Leaves hold the boxes themselves.
+ */
+template<int N>
+struct IndexNode {
+  IndexNode();
+  ~IndexNode();
+  bool isLeaf() const { return left == nullptr; }
+  // Children, or nullptr for a leaf. Boxes with u[dim] < key are in left.
+  IndexNode<N> * left;
+  IndexNode<N> * right;
+  int dim;
+  CPXLONG key;
+  // Bounds on u over all boxes ever inserted below this node since the
+  // last rebuild.
+  CPXLONG lo[N];
+  CPXLONG hi[N];
+  // Only used in leaves. u[i][k] is boxes[k]->u[i], so that leaves can be
+  // searched with the kernels in dominance.hpp.
+  std::vector<Box<N> *> boxes;
+  std::vector<CPXLONG> u[N];
+};
+
+/**
+ * A spatial index over the u corners of the live boxes, so that the boxes a
+ * new point lies in can be found without looking at every box.
+ *
+ * This is a k-d tree with buckets of boxes at the leaves. Every node records
+ * the smallest and largest u in its subtree in each objective, and a query
+ * skips every subtree whose bounds show that none of its boxes can contain
+ * the point. Each box records the leaf it is in and its position there, so
+ * erase() is constant time. Bounds are not shrunk by erase(), and splits are
+ * chosen when leaves fill up, so the tree is rebuilt from scratch once more
+ * boxes have been erased since the last rebuild than are currently stored.
+ *
+ * Each leaf also keeps the u corners of its boxes as one column per
+ * objective, which are searched with a SIMD kernel (see dominance.hpp).
+ */
+template<int N>
+class BoxIndex {
+  public:
+    explicit BoxIndex(Sense sense);
+    ~BoxIndex();
+
+    void insert(Box<N> * b);
+    void erase(Box<N> * b);
+    size_t size() const;
+
+    /**
+     * Append to out every box that contains p, i.e. every box whose u is
+     * strictly greater than p in every objective when minimising (strictly
+     * less when maximising).
+     */
+    void containing(const CPXLONG p[], std::vector<Box<N> *> & out) const;
+
+    /**
+     * Append every box in the index to out.
+     */
+    void all(std::vector<Box<N> *> & out) const;
+
+  private:
+    static constexpr size_t LEAF_SIZE = 64;
+
+    void grow(IndexNode<N> * n, const Box<N> * b);
+    void place(IndexNode<N> * leaf, Box<N> * b);
+    void splitLeaf(IndexNode<N> * leaf);
+    IndexNode<N> * build(typename std::vector<Box<N> *>::iterator begin,
+                 typename std::vector<Box<N> *>::iterator end);
+    void rebuild();
+    void collect(IndexNode<N> * n, std::vector<Box<N> *> & out) const;
+    void query(const IndexNode<N> * n, const CPXLONG p[],
+               std::vector<Box<N> *> & out) const;
+
+    Sense sense_;
+    IndexNode<N> * root_;
+    size_t size_;
+    size_t erased_;
+};
+
+template<int N>
+inline IndexNode<N>::IndexNode() : left(nullptr), right(nullptr), dim(0),
+    key(0) {
+  for(int i = 0; i < N; ++i) {
+    lo[i] = hi[i] = 0;
+  }
+}
+
+template<int N>
+inline IndexNode<N>::~IndexNode() {
+  delete left;
+  delete right;
+}
+
+template<int N>
+inline BoxIndex<N>::BoxIndex(Sense sense) : sense_(sense), root_(new IndexNode<N>()),
+    size_(0), erased_(0) {
+}
+
+template<int N>
+inline BoxIndex<N>::~BoxIndex() {
+  delete root_;
+}
+
+template<int N>
+inline size_t BoxIndex<N>::size() const {
+  return size_;
+}
+
+template<int N>
+inline void BoxIndex<N>::grow(IndexNode<N> * n, const Box<N> * b) {
+  for(int i = 0; i < N; ++i) {
+    n->lo[i] = std::min(n->lo[i], b->u[i]);
+    n->hi[i] = std::max(n->hi[i], b->u[i]);
+  }
+}
+
+template<int N>
+inline void BoxIndex<N>::place(IndexNode<N> * leaf, Box<N> * b) {
+  b->leaf = leaf;
+  b->slot = leaf->boxes.size();
+  leaf->boxes.push_back(b);
+  for(int i = 0; i < N; ++i) {
+    leaf->u[i].push_back(b->u[i]);
+  }
+}
+
+template<int N>
+inline void BoxIndex<N>::insert(Box<N> * b) {
+  IndexNode<N> * n = root_;
+  // The root's bounds are only meaningful once something is in the tree.
+  if (size_ == 0 && root_->isLeaf()) {
+    for(int i = 0; i < N; ++i) {
+      root_->lo[i] = root_->hi[i] = b->u[i];
+    }
+  }
+  for(;;) {
+    grow(n, b);
+    if (n->isLeaf()) {
+      break;
+    }
+    n = (b->u[n->dim] < n->key) ? n->left : n->right;
+  }
+  place(n, b);
+  size_ += 1;
+  if (n->boxes.size() > LEAF_SIZE) {
+    splitLeaf(n);
+  }
+}
+
+template<int N>
+inline void BoxIndex<N>::erase(Box<N> * b) {
+  IndexNode<N> * leaf = b->leaf;
+  if (leaf == nullptr) {
+    return;
+  }
+  Box<N> * last = leaf->boxes.back();
+  leaf->boxes[b->slot] = last;
+  for(int i = 0; i < N; ++i) {
+    leaf->u[i][b->slot] = leaf->u[i].back();
+    leaf->u[i].pop_back();
+  }
+  last->slot = b->slot;
+  leaf->boxes.pop_back();
+  b->leaf = nullptr;
+  size_ -= 1;
+  erased_ += 1;
+  if ((erased_ > size_) && (erased_ > LEAF_SIZE)) {
+    rebuild();
+  }
+}
+
+template<int N>
+inline void BoxIndex<N>::splitLeaf(IndexNode<N> * leaf) {
+  // Split on the objective with the widest spread, at the median, as long as
+  // that puts at least one box on each side.
+  int order[N];
+  for(int i = 0; i < N; ++i) {
+    order[i] = i;
+  }
+  std::sort(order, order + N, [leaf](int a, int b) {
+      return (leaf->hi[a] - leaf->lo[a]) > (leaf->hi[b] - leaf->lo[b]);
+    });
+  for(int d: order) {
+    if (leaf->hi[d] == leaf->lo[d]) {
+      // All boxes agree in this objective, and in any later one.
+      return;
+    }
+    std::vector<CPXLONG> values;
+    values.reserve(leaf->boxes.size());
+    for(auto b: leaf->boxes) {
+      values.push_back(b->u[d]);
+    }
+    auto mid = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), mid, values.end());
+    CPXLONG key = *mid;
+    if (key == leaf->lo[d]) {
+      // Too many boxes share the smallest value; split just above it.
+      key = leaf->hi[d];
+      for(auto v: values) {
+        if ((v > leaf->lo[d]) && (v < key)) {
+          key = v;
+        }
+      }
+    }
+    leaf->dim = d;
+    leaf->key = key;
+    leaf->left = new IndexNode<N>();
+    leaf->right = new IndexNode<N>();
+    std::vector<Box<N> *> boxes;
+    boxes.swap(leaf->boxes);
+    for(int i = 0; i < N; ++i) {
+      std::vector<CPXLONG>().swap(leaf->u[i]);
+    }
+    for(auto b: boxes) {
+      IndexNode<N> * child = (b->u[d] < key) ? leaf->left : leaf->right;
+      if (child->boxes.empty()) {
+        for(int i = 0; i < N; ++i) {
+          child->lo[i] = child->hi[i] = b->u[i];
+        }
+      }
+      grow(child, b);
+      place(child, b);
+    }
+    return;
+  }
+}
+
+template<int N>
+inline IndexNode<N> * BoxIndex<N>::build(typename std::vector<Box<N> *>::iterator begin,
+    typename std::vector<Box<N> *>::iterator end) {
+  IndexNode<N> * n = new IndexNode<N>();
+  if (begin == end) {
+    return n;
+  }
+  for(int i = 0; i < N; ++i) {
+    n->lo[i] = n->hi[i] = (*begin)->u[i];
+  }
+  for(auto it = begin; it != end; ++it) {
+    grow(n, *it);
+  }
+  if (static_cast<size_t>(end - begin) <= LEAF_SIZE) {
+    for(auto it = begin; it != end; ++it) {
+      place(n, *it);
+    }
+    return n;
+  }
+  int d = 0;
+  for(int i = 1; i < N; ++i) {
+    if ((n->hi[i] - n->lo[i]) > (n->hi[d] - n->lo[d])) {
+      d = i;
+    }
+  }
+  if (n->hi[d] == n->lo[d]) {
+    // Every box has the same u; nothing to split on.
+    for(auto it = begin; it != end; ++it) {
+      place(n, *it);
+    }
+    return n;
+  }
+  auto mid = begin + (end - begin) / 2;
+  std::nth_element(begin, mid, end, [d](const Box<N> * a, const Box<N> * b) {
+      return a->u[d] < b->u[d];
+    });
+  CPXLONG key = (*mid)->u[d];
+  // Boxes equal to the key must all go right, so partition on it exactly.
+  mid = std::partition(begin, end, [d, key](const Box<N> * b) {
+      return b->u[d] < key;
+    });
+  if (mid == begin) {
+    // The key is the smallest value, so split just above it instead.
+    mid = std::partition(begin, end, [d, key](const Box<N> * b) {
+        return b->u[d] <= key;
+      });
+    key = (*mid)->u[d];
+  }
+  n->dim = d;
+  n->key = key;
+  n->left = build(begin, mid);
+  n->right = build(mid, end);
+  return n;
+}
+
+template<int N>
+inline void BoxIndex<N>::collect(IndexNode<N> * n, std::vector<Box<N> *> & out) const {
+  if (n->isLeaf()) {
+    out.insert(out.end(), n->boxes.begin(), n->boxes.end());
+    return;
+  }
+  collect(n->left, out);
+  collect(n->right, out);
+}
+
+template<int N>
+inline void BoxIndex<N>::rebuild() {
+  std::vector<Box<N> *> all;
+  all.reserve(size_);
+  collect(root_, all);
+  delete root_;
+  root_ = build(all.begin(), all.end());
+  erased_ = 0;
+}
+
+template<int N>
+inline void BoxIndex<N>::query(const IndexNode<N> * n, const CPXLONG p[],
+    std::vector<Box<N> *> & out) const {
+  // Can any box below n contain p?
+  for(int i = 0; i < N; ++i) {
+    if (((sense_ == MIN) && (n->hi[i] <= p[i])) ||
+        ((sense_ == MAX) && (n->lo[i] >= p[i]))) {
+      return;
+    }
+  }
+  if (! n->isLeaf()) {
+    query(n->left, p, out);
+    query(n->right, p, out);
+    return;
+  }
+  // Test 64 boxes at a time, then pick out the ones whose bit is set.
+  const CPXLONG * cols[N];
+  for(size_t start = 0; start < n->boxes.size(); start += 64) {
+    size_t count = std::min<size_t>(64, n->boxes.size() - start);
+    for(int i = 0; i < N; ++i) {
+      cols[i] = n->u[i].data() + start;
+    }
+    uint64_t mask = containingMask(cols, N, count, p, sense_);
+    while (mask != 0) {
+      out.push_back(n->boxes[start + __builtin_ctzll(mask)]);
+      mask &= mask - 1;
+    }
+  }
+}
+
+template<int N>
+inline void BoxIndex<N>::containing(const CPXLONG p[],
+    std::vector<Box<N> *> & out) const {
+  if (size_ == 0) {
+    return;
+  }
+  query(root_, p, out);
+}
+
+template<int N>
+inline void BoxIndex<N>::all(std::vector<Box<N> *> & out) const {
+  collect(root_, out);
+}
+
+#endif /* BOXINDEX_HPP */
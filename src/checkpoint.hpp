@@ -0,0 +1,197 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <ilcplex/cplexx.h>
+
+#include "sense.hpp"
+
+/**
+ * A snapshot of a run with N objectives: the utopia point, the number of IPs
+ * solved, every point found and every box that still has to be solved. This
+ * is enough to carry on from where the run was stopped.
+ *
+ * The file is binary, in the byte order of the machine that wrote it:
+ *   8 bytes  magic "BOXCKPT1"
+ *   int32    N
+ *   int32    sense (0 = MIN, 1 = MAX)
+ *   int64    IPs solved
+ *   int64    utopia[N]
+ *   uint64   number of points, then for each point int64 soln[N]
+ *   uint64   number of boxes, then for each box int64 u[N], int64 v[N],
+ *            int32 depth
+ */
+template<int N>
+class Checkpoint {
+  public:
+    struct BoxRecord {
+      CPXLONG u[N];
+      CPXLONG v[N];
+      int depth;
+    };
+    struct Point {
+      CPXLONG soln[N];
+    };
+
+    Checkpoint() : sense(MIN), ipcount(0) { }
+
+    /**
+     * Write to filename. The file is written under a temporary name and then
+     * renamed, so an existing checkpoint is only replaced by a complete one.
+     * Returns false on failure.
+     */
+    bool write(const std::string & filename) const;
+
+    /**
+     * Read from filename. Returns false, with a message on std::cerr, if the
+     * file can't be read or was written for a different number of
+     * objectives.
+     */
+    bool read(const std::string & filename);
+
+    Sense sense;
+    CPXLONG utopia[N];
+    CPXLONG ipcount;
+    std::vector<Point> points;
+    std::vector<BoxRecord> boxes;
+
+  private:
+    static constexpr const char * MAGIC = "BOXCKPT1";
+};
+
+template<int N>
+inline bool Checkpoint<N>::write(const std::string & filename) const {
+  std::string tmpname = filename + ".tmp";
+  {
+    std::ofstream out(tmpname, std::ios::binary | std::ios::trunc);
+    int32_t n = N;
+    int32_t s = (sense == MIN) ? 0 : 1;
+    int64_t ips = ipcount;
+    uint64_t count;
+    out.write(MAGIC, 8);
+    out.write(reinterpret_cast<const char *>(&n), sizeof(n));
+    out.write(reinterpret_cast<const char *>(&s), sizeof(s));
+    out.write(reinterpret_cast<const char *>(&ips), sizeof(ips));
+    for(int i = 0; i < N; ++i) {
+      int64_t value = utopia[i];
+      out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+    count = points.size();
+    out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    for(auto & p: points) {
+      for(int i = 0; i < N; ++i) {
+        int64_t value = p.soln[i];
+        out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+      }
+    }
+    count = boxes.size();
+    out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    for(auto & b: boxes) {
+      for(int i = 0; i < N; ++i) {
+        int64_t value = b.u[i];
+        out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+      }
+      for(int i = 0; i < N; ++i) {
+        int64_t value = b.v[i];
+        out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+      }
+      int32_t depth = b.depth;
+      out.write(reinterpret_cast<const char *>(&depth), sizeof(depth));
+    }
+    if (! out.good()) {
+      return false;
+    }
+  }
+  return std::rename(tmpname.c_str(), filename.c_str()) == 0;
+}
+
+template<int N>
+inline bool Checkpoint<N>::read(const std::string & filename) {
+  std::ifstream in(filename, std::ios::binary);
+  if (! in.good()) {
+    std::cerr << "Error: Could not open checkpoint " << filename << std::endl;
+    return false;
+  }
+  char magic[8];
+  int32_t n, s;
+  int64_t ips;
+  uint64_t count;
+  in.read(magic, 8);
+  in.read(reinterpret_cast<char *>(&n), sizeof(n));
+  in.read(reinterpret_cast<char *>(&s), sizeof(s));
+  in.read(reinterpret_cast<char *>(&ips), sizeof(ips));
+  if (! in.good() || std::memcmp(magic, MAGIC, 8) != 0) {
+    std::cerr << "Error: " << filename << " is not a checkpoint." << std::endl;
+    return false;
+  }
+  if (n != N) {
+    std::cerr << "Error: Checkpoint " << filename << " has " << n
+      << " objectives, but the problem has " << N << "." << std::endl;
+    return false;
+  }
+  sense = (s == 0) ? MIN : MAX;
+  ipcount = ips;
+  for(int i = 0; i < N; ++i) {
+    int64_t value;
+    in.read(reinterpret_cast<char *>(&value), sizeof(value));
+    utopia[i] = value;
+  }
+  in.read(reinterpret_cast<char *>(&count), sizeof(count));
+  points.clear();
+  for(uint64_t k = 0; (k < count) && in.good(); ++k) {
+    Point p;
+    for(int i = 0; i < N; ++i) {
+      int64_t value;
+      in.read(reinterpret_cast<char *>(&value), sizeof(value));
+      p.soln[i] = value;
+    }
+    points.push_back(p);
+  }
+  in.read(reinterpret_cast<char *>(&count), sizeof(count));
+  boxes.clear();
+  for(uint64_t k = 0; (k < count) && in.good(); ++k) {
+    BoxRecord b;
+    for(int i = 0; i < N; ++i) {
+      int64_t value;
+      in.read(reinterpret_cast<char *>(&value), sizeof(value));
+      b.u[i] = value;
+    }
+    for(int i = 0; i < N; ++i) {
+      int64_t value;
+      in.read(reinterpret_cast<char *>(&value), sizeof(value));
+      b.v[i] = value;
+    }
+    int32_t depth;
+    in.read(reinterpret_cast<char *>(&depth), sizeof(depth));
+    b.depth = depth;
+    boxes.push_back(b);
+  }
+  if (! in.good()) {
+    std::cerr << "Error: Checkpoint " << filename << " is truncated."
+      << std::endl;
+    return false;
+  }
+  return true;
+}
+
+#endif /* CHECKPOINT_HPP */
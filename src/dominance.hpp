@@ -0,0 +1,134 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+#ifndef DOMINANCE_HPP
+#define DOMINANCE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <ilcplex/cplexx.h>
+
+#include "sense.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BOXFINDER_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+/**
+ * Kernels for finding which boxes contain a point, over boxes stored as
+ * structure-of-arrays: u[i][k] is the i'th objective of the u corner of box k.
+ *
+ * Each kernel looks at up to 64 boxes starting at box 0 and returns a mask
+ * with bit k set if box k contains p, that is if p[i] < u[i][k] for every
+ * objective i when minimising (p[i] > u[i][k] when maximising). The AVX2 and
+ * AVX-512 versions are only used if the CPU supports them; containingMask()
+ * picks the best one once.
+ */
+typedef uint64_t (*MaskKernel)(const CPXLONG * const u[], int objcnt,
+                               size_t count, const CPXLONG p[], Sense sense);
+
+inline uint64_t containingMaskScalar(const CPXLONG * const u[], int objcnt,
+    size_t count, const CPXLONG p[], Sense sense) {
+  uint64_t mask = 0;
+  for(size_t k = 0; k < count; ++k) {
+    bool inside = true;
+    for(int i = 0; i < objcnt; ++i) {
+      if (sense == MIN) {
+        inside &= (p[i] < u[i][k]);
+      } else {
+        inside &= (p[i] > u[i][k]);
+      }
+    }
+    mask |= static_cast<uint64_t>(inside) << k;
+  }
+  return mask;
+}
+
+#ifdef BOXFINDER_X86_KERNELS
+__attribute__((target("avx2")))
+inline uint64_t containingMaskAVX2(const CPXLONG * const u[], int objcnt,
+    size_t count, const CPXLONG p[], Sense sense) {
+  uint64_t mask = 0;
+  size_t k = 0;
+  for(; k + 4 <= count; k += 4) {
+    __m256i inside = _mm256_set1_epi64x(-1);
+    for(int i = 0; i < objcnt; ++i) {
+      __m256i col = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i *>(u[i] + k));
+      __m256i pt = _mm256_set1_epi64x(p[i]);
+      __m256i cmp = (sense == MIN) ? _mm256_cmpgt_epi64(col, pt)
+                                   : _mm256_cmpgt_epi64(pt, col);
+      inside = _mm256_and_si256(inside, cmp);
+    }
+    uint64_t bits = _mm256_movemask_pd(_mm256_castsi256_pd(inside));
+    mask |= bits << k;
+  }
+  if (k < count) {
+    const CPXLONG * rest[objcnt];
+    for(int i = 0; i < objcnt; ++i) {
+      rest[i] = u[i] + k;
+    }
+    mask |= containingMaskScalar(rest, objcnt, count - k, p, sense) << k;
+  }
+  return mask;
+}
+
+__attribute__((target("avx512f")))
+inline uint64_t containingMaskAVX512(const CPXLONG * const u[], int objcnt,
+    size_t count, const CPXLONG p[], Sense sense) {
+  uint64_t mask = 0;
+  for(size_t k = 0; k < count; k += 8) {
+    // The last few boxes are handled with a masked load.
+    __mmask8 live = (count - k >= 8) ? 0xFF
+                                     : static_cast<__mmask8>((1u << (count - k)) - 1);
+    __mmask8 inside = live;
+    for(int i = 0; i < objcnt; ++i) {
+      __m512i col = _mm512_maskz_loadu_epi64(live, u[i] + k);
+      __m512i pt = _mm512_set1_epi64(p[i]);
+      if (sense == MIN) {
+        inside &= _mm512_cmpgt_epi64_mask(col, pt);
+      } else {
+        inside &= _mm512_cmpgt_epi64_mask(pt, col);
+      }
+    }
+    mask |= static_cast<uint64_t>(inside) << k;
+  }
+  return mask;
+}
+#endif
+
+/**
+ * The fastest kernel this CPU supports.
+ */
+inline MaskKernel bestMaskKernel() {
+#ifdef BOXFINDER_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return containingMaskAVX512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return containingMaskAVX2;
+  }
+#endif
+  return containingMaskScalar;
+}
+
+inline uint64_t containingMask(const CPXLONG * const u[], int objcnt,
+    size_t count, const CPXLONG p[], Sense sense) {
+  static const MaskKernel kernel = bestMaskKernel();
+  return kernel(u, objcnt, count, p, sense);
+}
+
+#endif /* DOMINANCE_HPP */
@@ -0,0 +1,534 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <ilcplex/cplexx.h>
+
+#include "enumerator.hpp"
+#include "model.hpp"
+#include "problem.hpp"
+
+namespace {
+constexpr double INF = std::numeric_limits<double>::infinity();
+// Slack allowed when comparing row activities with their bounds.
+constexpr double TOLERANCE = 1e-6;
+
+/**
+ * How much better a point must be than the best so far to count as better.
+ */
+inline double margin(double best) {
+  return 1e-9 * std::max(1.0, std::abs(best));
+}
+}
+
+BranchAndBound::BranchAndBound(const Problem & p) : goal(SCALARISED),
+    single(0), sense(p.objsen), rho(0), sumLo(-INF), sumHi(INF),
+    abort(nullptr), bounded_(false), found_(false), stop_(false), best_(0) {
+  const Model & m = p.model();
+  numcols_ = m.numcols;
+  objcnt_ = p.objcnt;
+  weight.assign(objcnt_, 0);
+  utopia.assign(objcnt_, 0);
+  lo.assign(objcnt_, -INF);
+  hi.assign(objcnt_, INF);
+
+  rowLo_.resize(m.numrows);
+  rowHi_.resize(m.numrows);
+  for(CPXDIM i = 0; i < m.numrows; ++i) {
+    double rlo, rhi;
+    switch (m.sense[i]) {
+      case 'L':
+        rlo = -INF;
+        rhi = m.rhs[i];
+        break;
+      case 'G':
+        rlo = m.rhs[i];
+        rhi = INF;
+        break;
+      case 'R':
+        rlo = m.rhs[i] + std::min(0.0, m.rngval[i]);
+        rhi = m.rhs[i] + std::max(0.0, m.rngval[i]);
+        break;
+      case 'E':
+      default:
+        rlo = m.rhs[i];
+        rhi = m.rhs[i];
+        break;
+    }
+    // The objective rows are kept, but with infinite bounds.
+    rowLo_[i] = (rlo <= -CPX_INFBOUND) ? -INF : rlo;
+    rowHi_[i] = (rhi >= CPX_INFBOUND) ? INF : rhi;
+  }
+
+  columns_.resize(numcols_);
+  for(CPXDIM j = 0; j < numcols_; ++j) {
+    for(CPXNNZ k = m.matbeg[j]; k < m.matbeg[j] + m.matcnt[j]; ++k) {
+      CPXDIM row = m.matind[k];
+      if ((rowLo_[row] == -INF) && (rowHi_[row] == INF)) {
+        continue;
+      }
+      columns_[j].push_back(Entry{row, m.matval[k]});
+    }
+  }
+
+  std::vector<double> lb(numcols_);
+  std::vector<double> ub(numcols_);
+  for(CPXDIM j = 0; j < numcols_; ++j) {
+    lb[j] = (m.lb[j] <= -CPX_INFBOUND) ? -INF : m.lb[j];
+    ub[j] = (m.ub[j] >= CPX_INFBOUND) ? INF : m.ub[j];
+  }
+  tighten(lb, ub);
+  bounded_ = true;
+  lb_.resize(numcols_);
+  ub_.resize(numcols_);
+  for(CPXDIM j = 0; j < numcols_; ++j) {
+    bounded_ &= std::isfinite(lb[j]) && std::isfinite(ub[j]);
+    lb_[j] = std::isfinite(lb[j]) ? std::llround(std::ceil(lb[j] - TOLERANCE)) : 0;
+    ub_[j] = std::isfinite(ub[j]) ? std::llround(std::floor(ub[j] + TOLERANCE)) : 0;
+  }
+
+  obj_.resize(objcnt_);
+  for(int k = 0; k < objcnt_; ++k) {
+    obj_[k].assign(numcols_, 0);
+    for(int n = 0; n < p.objnzcnt[k]; ++n) {
+      obj_[k][p.objind[k][n]] = p.objcoef[k][n];
+    }
+  }
+}
+
+bool BranchAndBound::canSolve(const Problem & p) {
+  const Model & m = p.model();
+  if (m.ctype.empty()) {
+    std::cerr << "The enumeration backend can only solve integer problems."
+      << std::endl;
+    return false;
+  }
+  for(CPXDIM j = 0; j < m.numcols; ++j) {
+    if ((m.ctype[j] != CPX_BINARY) && (m.ctype[j] != CPX_INTEGER)) {
+      std::cerr << "The enumeration backend can only solve pure integer "
+        "problems." << std::endl;
+      return false;
+    }
+  }
+  if (! BranchAndBound(p).bounded_) {
+    std::cerr << "The enumeration backend needs every variable to have "
+      "finite bounds, either given or implied by the constraints."
+      << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void BranchAndBound::tighten(std::vector<double> & lb,
+    std::vector<double> & ub) const {
+  // The same rows, row by row.
+  std::vector<std::vector<std::pair<CPXDIM, double>>> rows(rowLo_.size());
+  for(CPXDIM j = 0; j < numcols_; ++j) {
+    for(auto & entry: columns_[j]) {
+      rows[entry.row].emplace_back(j, entry.val);
+    }
+  }
+  // Each variable is integer, so a bound implied by a row can be rounded.
+  // A few passes catch bounds that follow from other implied bounds.
+  bool changed = true;
+  for(int pass = 0; changed && (pass < 10); ++pass) {
+    changed = false;
+    for(size_t i = 0; i < rows.size(); ++i) {
+      // The smallest and largest activity of the row, leaving out the
+      // terms that are unbounded, and how many of those there are.
+      double minAct = 0;
+      double maxAct = 0;
+      int minInf = 0;
+      int maxInf = 0;
+      for(auto & term: rows[i]) {
+        double low = term.second * ((term.second > 0) ? lb[term.first]
+                                                      : ub[term.first]);
+        double high = term.second * ((term.second > 0) ? ub[term.first]
+                                                       : lb[term.first]);
+        if (std::isfinite(low)) {
+          minAct += low;
+        } else {
+          minInf++;
+        }
+        if (std::isfinite(high)) {
+          maxAct += high;
+        } else {
+          maxInf++;
+        }
+      }
+      for(auto & term: rows[i]) {
+        CPXDIM j = term.first;
+        double a = term.second;
+        double low = a * ((a > 0) ? lb[j] : ub[j]);
+        double high = a * ((a > 0) ? ub[j] : lb[j]);
+        // The smallest activity of the rest of the row, if it is finite.
+        if ((rowHi_[i] != INF) && ((minInf == 0) ||
+              ((minInf == 1) && ! std::isfinite(low)))) {
+          double rest = std::isfinite(low) ? minAct - low : minAct;
+          double limit = (rowHi_[i] - rest) / a;
+          if ((a > 0) && (std::floor(limit + TOLERANCE) < ub[j])) {
+            ub[j] = std::floor(limit + TOLERANCE);
+            changed = true;
+          } else if ((a < 0) && (std::ceil(limit - TOLERANCE) > lb[j])) {
+            lb[j] = std::ceil(limit - TOLERANCE);
+            changed = true;
+          }
+        }
+        if ((rowLo_[i] != -INF) && ((maxInf == 0) ||
+              ((maxInf == 1) && ! std::isfinite(high)))) {
+          double rest = std::isfinite(high) ? maxAct - high : maxAct;
+          double limit = (rowLo_[i] - rest) / a;
+          if ((a > 0) && (std::ceil(limit - TOLERANCE) > lb[j])) {
+            lb[j] = std::ceil(limit - TOLERANCE);
+            changed = true;
+          } else if ((a < 0) && (std::floor(limit + TOLERANCE) < ub[j])) {
+            ub[j] = std::floor(limit + TOLERANCE);
+            changed = true;
+          }
+        }
+      }
+    }
+  }
+}
+
+void BranchAndBound::clear() {
+  found_ = false;
+}
+
+double BranchAndBound::value(const std::vector<double> & f) const {
+  double s = (sense == MIN) ? 1 : -1;
+  switch (goal) {
+    case SCALARISED: {
+      double max_diff = 0;
+      double sum = 0;
+      for(int k = 0; k < objcnt_; ++k) {
+        max_diff = std::max(max_diff, s * weight[k] * (f[k] - utopia[k]));
+        sum += f[k];
+      }
+      return max_diff + s * rho * sum;
+    }
+    case SINGLE:
+      return s * f[single];
+    case FEASIBLE:
+    default:
+      return 0;
+  }
+}
+
+double BranchAndBound::bound() const {
+  double s = (sense == MIN) ? 1 : -1;
+  switch (goal) {
+    case SCALARISED: {
+      // Each term is linear in one objective, so is smallest at one end of
+      // that objective's interval.
+      double max_diff = 0;
+      double sumMin = 0;
+      double sumMax = 0;
+      for(int k = 0; k < objcnt_; ++k) {
+        double low = s * weight[k] * (fMin_[k] - utopia[k]);
+        double high = s * weight[k] * (fMax_[k] - utopia[k]);
+        max_diff = std::max(max_diff, std::min(low, high));
+        sumMin += fMin_[k];
+        sumMax += fMax_[k];
+      }
+      return max_diff + std::min(s * rho * sumMin, s * rho * sumMax);
+    }
+    case SINGLE:
+      return (sense == MIN) ? fMin_[single] : -fMax_[single];
+    case FEASIBLE:
+    default:
+      return 0;
+  }
+}
+
+bool BranchAndBound::objectivesFeasible() const {
+  double sumMin = 0;
+  double sumMax = 0;
+  for(int k = 0; k < objcnt_; ++k) {
+    if ((fMin_[k] > hi[k] + TOLERANCE) || (fMax_[k] < lo[k] - TOLERANCE)) {
+      return false;
+    }
+    sumMin += fMin_[k];
+    sumMax += fMax_[k];
+  }
+  return (sumMin <= sumHi + TOLERANCE) && (sumMax >= sumLo - TOLERANCE);
+}
+
+bool BranchAndBound::narrow(CPXDIM j, CPXLONG from, CPXLONG to) {
+  double dLb = static_cast<double>(from - curLb_[j]);
+  double dUb = static_cast<double>(to - curUb_[j]);
+  bool feasible = true;
+  for(auto & entry: columns_[j]) {
+    if (entry.val > 0) {
+      minAct_[entry.row] += entry.val * dLb;
+      maxAct_[entry.row] += entry.val * dUb;
+    } else {
+      minAct_[entry.row] += entry.val * dUb;
+      maxAct_[entry.row] += entry.val * dLb;
+    }
+    feasible &= (minAct_[entry.row] <= rowHi_[entry.row] + TOLERANCE) &&
+                (maxAct_[entry.row] >= rowLo_[entry.row] - TOLERANCE);
+  }
+  for(int k = 0; k < objcnt_; ++k) {
+    double c = obj_[k][j];
+    if (c > 0) {
+      fMin_[k] += c * dLb;
+      fMax_[k] += c * dUb;
+    } else if (c < 0) {
+      fMin_[k] += c * dUb;
+      fMax_[k] += c * dLb;
+    }
+  }
+  curLb_[j] = from;
+  curUb_[j] = to;
+  return feasible && objectivesFeasible();
+}
+
+bool BranchAndBound::offer(const std::vector<double> & x) {
+  if (static_cast<CPXDIM>(x.size()) != numcols_) {
+    return false;
+  }
+  std::vector<CPXLONG> point(numcols_);
+  std::vector<double> act(rowLo_.size(), 0);
+  std::vector<double> f(objcnt_, 0);
+  for(CPXDIM j = 0; j < numcols_; ++j) {
+    point[j] = std::lround(x[j]);
+    if ((point[j] < lb_[j]) || (point[j] > ub_[j])) {
+      return false;
+    }
+    for(auto & entry: columns_[j]) {
+      act[entry.row] += entry.val * point[j];
+    }
+    for(int k = 0; k < objcnt_; ++k) {
+      f[k] += obj_[k][j] * point[j];
+    }
+  }
+  for(size_t i = 0; i < act.size(); ++i) {
+    if ((act[i] > rowHi_[i] + TOLERANCE) || (act[i] < rowLo_[i] - TOLERANCE)) {
+      return false;
+    }
+  }
+  double sum = 0;
+  for(int k = 0; k < objcnt_; ++k) {
+    if ((f[k] > hi[k] + TOLERANCE) || (f[k] < lo[k] - TOLERANCE)) {
+      return false;
+    }
+    sum += f[k];
+  }
+  if ((sum > sumHi + TOLERANCE) || (sum < sumLo - TOLERANCE)) {
+    return false;
+  }
+  double v = value(f);
+  if (found_ && (v >= best_ - margin(best_))) {
+    return false;
+  }
+  found_ = true;
+  best_ = v;
+  bestX_ = point;
+  bestF_.resize(objcnt_);
+  for(int k = 0; k < objcnt_; ++k) {
+    bestF_[k] = std::lround(f[k]);
+  }
+  return true;
+}
+
+SolveStatus BranchAndBound::run() {
+  stop_ = false;
+  curLb_ = lb_;
+  curUb_ = ub_;
+  minAct_.assign(rowLo_.size(), 0);
+  maxAct_.assign(rowLo_.size(), 0);
+  fMin_.assign(objcnt_, 0);
+  fMax_.assign(objcnt_, 0);
+  for(CPXDIM j = 0; j < numcols_; ++j) {
+    for(auto & entry: columns_[j]) {
+      minAct_[entry.row] += entry.val * (entry.val > 0 ? lb_[j] : ub_[j]);
+      maxAct_[entry.row] += entry.val * (entry.val > 0 ? ub_[j] : lb_[j]);
+    }
+    for(int k = 0; k < objcnt_; ++k) {
+      double c = obj_[k][j];
+      fMin_[k] += c * (c > 0 ? lb_[j] : ub_[j]);
+      fMax_[k] += c * (c > 0 ? ub_[j] : lb_[j]);
+    }
+  }
+  bool feasible = objectivesFeasible();
+  for(size_t i = 0; i < rowLo_.size(); ++i) {
+    feasible &= (minAct_[i] <= rowHi_[i] + TOLERANCE) &&
+                (maxAct_[i] >= rowLo_[i] - TOLERANCE);
+  }
+  if (feasible && ! search(0)) {
+    return SOLVE_ABORTED;
+  }
+  return found_ ? SOLVE_OPTIMAL : SOLVE_INFEASIBLE;
+}
+
+bool BranchAndBound::search(CPXDIM j) {
+  if ((abort != nullptr) && (*abort != 0)) {
+    return false;
+  }
+  if (found_ && (bound() >= best_ - margin(best_))) {
+    return true;
+  }
+  if (j == numcols_) {
+    // Every variable is fixed, so each objective interval is a single value.
+    double v = value(fMin_);
+    found_ = true;
+    best_ = v;
+    bestX_ = curLb_;
+    bestF_.resize(objcnt_);
+    for(int k = 0; k < objcnt_; ++k) {
+      bestF_[k] = std::lround(fMin_[k]);
+    }
+    stop_ = (goal == FEASIBLE);
+    return true;
+  }
+  // Try first the values that make the objectives better.
+  double s = (sense == MIN) ? 1 : -1;
+  double slope = 0;
+  if (goal == SINGLE) {
+    slope = obj_[single][j];
+  } else {
+    for(int k = 0; k < objcnt_; ++k) {
+      slope += obj_[k][j];
+    }
+  }
+  bool upwards = (s * slope >= 0);
+  CPXLONG oldLb = curLb_[j];
+  CPXLONG oldUb = curUb_[j];
+  for(CPXLONG n = 0; n <= oldUb - oldLb; ++n) {
+    CPXLONG v = upwards ? oldLb + n : oldUb - n;
+    bool ok = true;
+    if (narrow(j, v, v)) {
+      ok = search(j + 1);
+    }
+    narrow(j, oldLb, oldUb);
+    if (! ok) {
+      return false;
+    }
+    if (stop_) {
+      return true;
+    }
+  }
+  return true;
+}
+
+Enumerator::Enumerator(const Problem & master) : Solver(master),
+    bb_(master) {
+}
+
+void Enumerator::useUtopia() {
+  bb_.rho = rho_;
+  for(int count = 0; count < objcnt_; ++count) {
+    bb_.weight[order_[count]] = weights_[count];
+    bb_.utopia[order_[count]] = sortedUtopia_[count];
+  }
+  reset();
+}
+
+void Enumerator::setBox(const CPXLONG u[]) {
+  // The same bounds as the f_i columns of a Session.
+  for(int k = 0; k < objcnt_; ++k) {
+    if (sense_ == MIN) {
+      bb_.hi[k] = static_cast<double>(u[k]) - 0.5;
+    } else {
+      bb_.lo[k] = std::max(0.0, static_cast<double>(u[k]) + 0.5);
+    }
+  }
+}
+
+int Enumerator::warmStart(const std::vector<KnownPoint> & known) {
+  // Points outside the box can't be repaired here, so only those that
+  // happen to be feasible in it are used.
+  int used = 0;
+  for(auto & r: known) {
+    if (bb_.offer(*r.x)) {
+      used += 1;
+    }
+  }
+  return used;
+}
+
+void Enumerator::watch(volatile int * abort) {
+  bb_.abort = abort;
+}
+
+SolveStatus Enumerator::solve(CPXLONG soln[], std::vector<double> * x) {
+  SolveStatus status = bb_.run();
+  if (status != SOLVE_OPTIMAL) {
+    return status;
+  }
+  for(int k = 0; k < objcnt_; ++k) {
+    soln[k] = bb_.values()[k];
+  }
+  if (x != nullptr) {
+    x->assign(bb_.point().begin(), bb_.point().end());
+  }
+  return status;
+}
+
+bool Enumerator::verify(const CPXLONG soln[]) {
+  reset();
+  // Look for any point y with y <= soln and sum(y) < sum(soln) (or the
+  // reverse when maximising).
+  double sum = 0;
+  for(int k = 0; k < objcnt_; ++k) {
+    double value = static_cast<double>(soln[k]);
+    sum += value;
+    if (sense_ == MIN) {
+      bb_.hi[k] = value;
+    } else {
+      bb_.lo[k] = std::max(0.0, value);
+    }
+  }
+  if (sense_ == MIN) {
+    bb_.sumHi = sum - 1;
+  } else {
+    bb_.sumLo = sum + 1;
+  }
+  bb_.goal = BranchAndBound::FEASIBLE;
+  bool nondominated = (bb_.run() == SOLVE_INFEASIBLE);
+  reset();
+  return nondominated;
+}
+
+void Enumerator::reset() {
+  // Objective values are kept non-negative, like the f_i columns of a
+  // Session.
+  bb_.goal = BranchAndBound::SCALARISED;
+  for(int k = 0; k < objcnt_; ++k) {
+    bb_.lo[k] = 0;
+    bb_.hi[k] = INF;
+  }
+  bb_.sumLo = -INF;
+  bb_.sumHi = INF;
+  bb_.clear();
+}
+
+int Enumerator::bestValue(int i, CPXLONG & value) {
+  BranchAndBound bb(*p);
+  bb.goal = BranchAndBound::SINGLE;
+  bb.single = i;
+  if (bb.run() != SOLVE_OPTIMAL) {
+    std::cerr << "Failed to obtain objective value." << std::endl;
+    return 1;
+  }
+  value = bb.values()[i];
+  return 0;
+}
@@ -0,0 +1,195 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+
+#ifndef ENUMERATOR_HPP
+#define ENUMERATOR_HPP
+
+#include <vector>
+
+#include <ilcplex/cplexx.h>
+
+#include "problem.hpp"
+#include "sense.hpp"
+#include "solver.hpp"
+
+/**
+ * A depth-first branch and bound over the variables of a pure integer problem
+ * whose variables all have finite bounds, either given or implied by the
+ * constraints. Variables are fixed one at a time,
+ * in order, and a node is pruned as soon as interval bounds on the rows or
+ * the objectives show that it can't hold a feasible point that is better
+ * than the best found so far. This is only fast for small problems, but it
+ * needs no external solver.
+ */
+class BranchAndBound {
+  public:
+    explicit BranchAndBound(const Problem & p);
+
+    /**
+     * Whether p is a pure integer problem with bounded variables. If not,
+     * says why on std::cerr.
+     */
+    static bool canSolve(const Problem & p);
+
+    /**
+     * What run() looks for:
+     * SCALARISED - the point minimising the augmented Chebyshev
+     *              scalarisation given by weight, utopia and rho
+     * SINGLE - the best value of objective single
+     * FEASIBLE - any feasible point
+     */
+    enum Goal { SCALARISED, SINGLE, FEASIBLE };
+    Goal goal;
+    int single;
+    Sense sense;
+    // The scalarisation, indexed by objective.
+    std::vector<double> weight;
+    std::vector<double> utopia;
+    double rho;
+    // Inclusive limits on each objective value, and on their sum.
+    std::vector<double> lo;
+    std::vector<double> hi;
+    double sumLo;
+    double sumHi;
+    // Abort as soon as this is nonzero, or never if it is nullptr.
+    volatile int * abort;
+
+    /**
+     * Use x as the best point so far, if it is feasible, within the limits
+     * and better than the best point so far. Returns whether it was used.
+     */
+    bool offer(const std::vector<double> & x);
+
+    /**
+     * Forget the best point so far.
+     */
+    void clear();
+
+    SolveStatus run();
+
+    /**
+     * The objective values of the best point, after run() returns
+     * SOLVE_OPTIMAL.
+     */
+    const std::vector<CPXLONG> & values() const { return bestF_; }
+
+    /**
+     * The variables of the best point, after run() returns SOLVE_OPTIMAL.
+     */
+    const std::vector<CPXLONG> & point() const { return bestX_; }
+
+  private:
+    struct Entry {
+      CPXDIM row;
+      double val;
+    };
+
+    /**
+     * Try every value of variable j, and then the variables after it.
+     * Returns false if aborted.
+     */
+    bool search(CPXDIM j);
+
+    /**
+     * Narrow variable j from [lb, ub] to [from, to], keeping the row and
+     * objective intervals up to date. Returns false if a row touched by j or
+     * an objective can then no longer be satisfied.
+     */
+    bool narrow(CPXDIM j, CPXLONG from, CPXLONG to);
+
+    bool objectivesFeasible() const;
+
+    /**
+     * Tighten the bounds lb and ub of each variable using the rows, so that
+     * for example x has bounds [0, 3] if 84 x + ... <= 295 and every
+     * variable is non-negative.
+     */
+    void tighten(std::vector<double> & lb, std::vector<double> & ub) const;
+
+    /**
+     * A lower bound on the value of any point at this node.
+     */
+    double bound() const;
+
+    /**
+     * The value to minimise at a point with objective values f.
+     */
+    double value(const std::vector<double> & f) const;
+
+    CPXDIM numcols_;
+    int objcnt_;
+    // Whether every variable has finite bounds; lb_ and ub_ are only
+    // meaningful if so.
+    bool bounded_;
+    std::vector<CPXLONG> lb_;
+    std::vector<CPXLONG> ub_;
+    // The rows with a finite bound, column by column.
+    std::vector<std::vector<Entry>> columns_;
+    std::vector<double> rowLo_;
+    std::vector<double> rowHi_;
+    // obj_[k][j] is the coefficient of variable j in objective k.
+    std::vector<std::vector<double>> obj_;
+
+    // Search state: the current bounds of each variable, and the resulting
+    // intervals of each row activity and objective value.
+    std::vector<CPXLONG> curLb_;
+    std::vector<CPXLONG> curUb_;
+    std::vector<double> minAct_;
+    std::vector<double> maxAct_;
+    std::vector<double> fMin_;
+    std::vector<double> fMax_;
+
+    bool found_;
+    bool stop_;
+    double best_;
+    std::vector<CPXLONG> bestF_;
+    std::vector<CPXLONG> bestX_;
+};
+
+/**
+ * A Solver that uses BranchAndBound, for small pure integer problems, where
+ * starting a CPLEX environment for each worker costs more than the search.
+ * It keeps no solution pool.
+ */
+class Enumerator : public Solver {
+  public:
+    explicit Enumerator(const Problem & master);
+
+    static bool canSolve(const Problem & p) {
+      return BranchAndBound::canSolve(p);
+    }
+
+    void setBox(const CPXLONG u[]) override;
+
+    /**
+     * Known solutions that are feasible become the starting incumbent.
+     */
+    int warmStart(const std::vector<KnownPoint> & known) override;
+    using Solver::warmStart;
+
+    void watch(volatile int * abort) override;
+    SolveStatus solve(CPXLONG soln[], std::vector<double> * x) override;
+    bool verify(const CPXLONG soln[]) override;
+    void reset() override;
+
+    int bestValue(int i, CPXLONG & value) override;
+
+  protected:
+    void useUtopia() override;
+
+  private:
+    BranchAndBound bb_;
+};
+
+#endif /* ENUMERATOR_HPP */
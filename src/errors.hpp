@@ -14,5 +14,6 @@ You should have received a copy of the GNU General Public License along with thi
 #ifndef ERRORS_H
 #define ERRORS_H
 #define ERR_CPLEX -1
+#define ERR_FILE -2
 
 #endif /* ERRORS_H */
@@ -0,0 +1,264 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+/*
+ * Writes random multi-objective instances in the LP format read by
+ * Problem::read_lp_problem: the objective sense is given by an empty
+ * objective, and each objective is a constraint at the end of the problem
+ * whose RHS is its (1-based) position.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+/**
+ * Draws objective coefficients for each of objcnt objectives over count
+ * variables. The first objective is uniform on [1, range]. Each other
+ * objective mixes the first with fresh uniform values, so that with
+ * correlation 1 it equals the first, with 0 it is independent, and with -1 it
+ * is the first reversed (range + 1 - value), which gives conflicting
+ * objectives and many nondominated points.
+ */
+static std::vector<std::vector<int>> objectives(std::mt19937 & rng, int objcnt,
+    int count, int range, double correlation) {
+  std::uniform_int_distribution<int> uniform(1, range);
+  std::vector<std::vector<int>> obj(objcnt, std::vector<int>(count));
+  for(int j = 0; j < count; ++j) {
+    obj[0][j] = uniform(rng);
+  }
+  double weight = std::abs(correlation);
+  for(int k = 1; k < objcnt; ++k) {
+    for(int j = 0; j < count; ++j) {
+      int base = (correlation >= 0) ? obj[0][j] : range + 1 - obj[0][j];
+      obj[k][j] = std::lround(weight * base + (1 - weight) * uniform(rng));
+    }
+  }
+  return obj;
+}
+
+/**
+ * Write each objective as a constraint over the named variables.
+ */
+static void writeObjectives(std::ostream & out,
+    const std::vector<std::vector<int>> & obj,
+    const std::vector<std::string> & names, const char * sense) {
+  out << std::endl << "\\ Objectives, with the RHS of each giving its number"
+    << std::endl;
+  for(size_t k = 0; k < obj.size(); ++k) {
+    for(size_t j = 0; j < names.size(); ++j) {
+      out << (j == 0 ? " " : " + ") << obj[k][j] << " " << names[j];
+      if (j % 10 == 9) {
+        out << std::endl;
+      }
+    }
+    out << " " << sense << " " << k + 1 << std::endl;
+  }
+}
+
+static void writeBinaries(std::ostream & out,
+    const std::vector<std::string> & names) {
+  out << std::endl << "binaries" << std::endl;
+  for(size_t j = 0; j < names.size(); ++j) {
+    out << " " << names[j];
+    if (j % 10 == 9) {
+      out << std::endl;
+    }
+  }
+  if (names.size() % 10 != 0) {
+    out << std::endl;
+  }
+  out << "end" << std::endl;
+}
+
+/**
+ * Knapsack with size items and one capacity constraint of half the total
+ * weight, maximising every objective.
+ */
+static void knapsack(std::ostream & out, std::mt19937 & rng, int objcnt,
+    int size, double correlation) {
+  std::uniform_int_distribution<int> uniform(1, 100);
+  std::vector<std::string> names;
+  long total = 0;
+  out << "maximize 0" << std::endl << "subject to" << std::endl;
+  out << "\\ Capacity constraint" << std::endl;
+  for(int j = 0; j < size; ++j) {
+    names.push_back("x" + std::to_string(j));
+    int w = uniform(rng);
+    total += w;
+    out << (j == 0 ? " " : " + ") << w << " " << names[j];
+    if (j % 10 == 9) {
+      out << std::endl;
+    }
+  }
+  out << " <= " << total / 2 << std::endl;
+  writeObjectives(out, objectives(rng, objcnt, size, 100, correlation), names,
+      ">");
+  writeBinaries(out, names);
+}
+
+/**
+ * Assignment of size agents to size tasks, minimising every objective.
+ */
+static void assignment(std::ostream & out, std::mt19937 & rng, int objcnt,
+    int size, double correlation) {
+  std::vector<std::string> names;
+  for(int i = 1; i <= size; ++i) {
+    for(int j = 1; j <= size; ++j) {
+      names.push_back("X" + std::to_string(i) + "X" + std::to_string(j));
+    }
+  }
+  out << "minimize 0" << std::endl << "subject to" << std::endl;
+  out << "\\ Row assignment constraints" << std::endl;
+  for(int i = 0; i < size; ++i) {
+    for(int j = 0; j < size; ++j) {
+      out << (j == 0 ? " " : " + ") << names[i * size + j];
+    }
+    out << " = 1" << std::endl;
+  }
+  out << "\\ Column assignment constraints" << std::endl;
+  for(int j = 0; j < size; ++j) {
+    for(int i = 0; i < size; ++i) {
+      out << (i == 0 ? " " : " + ") << names[i * size + j];
+    }
+    out << " = 1" << std::endl;
+  }
+  writeObjectives(out,
+      objectives(rng, objcnt, size * size, 20, correlation), names, "<");
+  writeBinaries(out, names);
+}
+
+/**
+ * Set covering of size elements by 2 * size sets, minimising every
+ * objective. Each set covers each element with probability 0.1, and every
+ * element is covered by at least two sets.
+ */
+static void setcover(std::ostream & out, std::mt19937 & rng, int objcnt,
+    int size, double correlation) {
+  int sets = 2 * size;
+  std::vector<std::string> names;
+  for(int j = 0; j < sets; ++j) {
+    names.push_back("s" + std::to_string(j));
+  }
+  std::bernoulli_distribution covers(0.1);
+  std::uniform_int_distribution<int> pick(0, sets - 1);
+  out << "minimize 0" << std::endl << "subject to" << std::endl;
+  out << "\\ Covering constraints" << std::endl;
+  for(int i = 0; i < size; ++i) {
+    std::vector<int> row;
+    for(int j = 0; j < sets; ++j) {
+      if (covers(rng)) {
+        row.push_back(j);
+      }
+    }
+    while (row.size() < 2) {
+      int j = pick(rng);
+      if (std::find(row.begin(), row.end(), j) == row.end()) {
+        row.push_back(j);
+      }
+    }
+    std::sort(row.begin(), row.end());
+    for(size_t j = 0; j < row.size(); ++j) {
+      out << (j == 0 ? " " : " + ") << names[row[j]];
+    }
+    out << " >= 1" << std::endl;
+  }
+  writeObjectives(out, objectives(rng, objcnt, sets, 100, correlation), names,
+      "<");
+  writeBinaries(out, names);
+}
+
+int main(int argc, char* argv[]) {
+  std::string type, outputFilename;
+  int size, objcnt;
+  double correlation;
+  unsigned seed;
+
+  po::variables_map va_map;
+  po::options_description opt("Options for boxgen");
+  opt.add_options()
+    ("help,h", "Show this help.")
+    ("type",
+      po::value<std::string>(&type)->default_value("knapsack"),
+     "The kind of problem: knapsack, assignment or setcover. Optional, "
+     "default to knapsack.")
+    ("size,n",
+      po::value<int>(&size)->default_value(10),
+     "Items for knapsack, agents for assignment, or elements for setcover. "
+     "Optional, default to 10.")
+    ("objectives",
+      po::value<int>(&objcnt)->default_value(3),
+     "Number of objectives. Optional, default to 3.")
+    ("correlation",
+      po::value<double>(&correlation)->default_value(0),
+     "Correlation between the first objective and the others, from -1 "
+     "(conflicting) to 1 (equal). Optional, default to 0.")
+    ("seed",
+      po::value<unsigned>(&seed)->default_value(1),
+     "Random seed. The same options and seed always give the same instance. "
+     "Optional, default to 1.")
+    ("output,o",
+      po::value<std::string>(&outputFilename),
+     "The LP file to write. Required.")
+  ;
+
+  po::store(po::parse_command_line(argc, argv, opt), va_map);
+  po::notify(va_map);
+
+  if (va_map.count("help")) {
+    std::cout << opt << std::endl;
+    return(1);
+  }
+
+  if (va_map.count("output") == 0) {
+    std::cerr << "Error: You must pass in an output file." << std::endl;
+    std::cerr << opt << std::endl;
+    return(1);
+  }
+
+  if ((size < 1) || (objcnt < 1) || (correlation < -1) || (correlation > 1)) {
+    std::cerr << "Error: size and objectives must be positive, and "
+      "correlation between -1 and 1." << std::endl;
+    return(1);
+  }
+
+  std::ofstream out(outputFilename);
+  if (! out.good()) {
+    std::cerr << "Error: Could not open " << outputFilename << std::endl;
+    return(1);
+  }
+
+  std::mt19937 rng(seed);
+  out << "\\ " << type << " instance of size " << size << " with " << objcnt
+    << " objectives, correlation " << correlation << " and seed " << seed
+    << std::endl;
+  if (type == "knapsack") {
+    knapsack(out, rng, objcnt, size, correlation);
+  } else if (type == "assignment") {
+    assignment(out, rng, objcnt, size, correlation);
+  } else if (type == "setcover") {
+    setcover(out, rng, objcnt, size, correlation);
+  } else {
+    std::cerr << "Error: Unknown problem type " << type << std::endl;
+    return(1);
+  }
+  return 0;
+}
@@ -30,7 +30,10 @@ freely, subject to the following restrictions:
 #define JOBSERVER_H
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <future>
 #include <mutex>
@@ -38,11 +41,33 @@ freely, subject to the following restrictions:
 #include <thread>
 #include <vector>
 
+#include <sys/socket.h>
+
 #include "box.hpp"
 #include "boxfinder.hpp"
+#include "archive.hpp"
+#include "boxindex.hpp"
+#include "checkpoint.hpp"
+#include "problem.hpp"
+#include "recording.hpp"
+#include "remote.hpp"
 #include "result.hpp"
+#include "resultqueue.hpp"
+#include "scheduler.hpp"
+#include "solver.hpp"
+#include "streamwriter.hpp"
 #include "task.hpp"
+#include "trace.hpp"
 
+extern std::atomic<int> ipcount;
+
+/**
+ * The n'th objective other than i. With 3 objectives, other(i, 0) and
+ * other(i, 1) are the j and k of UpdateIndividualSubsets.
+ */
+constexpr int other(int i, int n) {
+  return (n < i) ? n : n + 1;
+}
 
 /**
  * Key function for sorting boxes as per UpdateIndividualSubsets
@@ -53,280 +78,1025 @@ freely, subject to the following restrictions:
  *              box[q]->v[j] \leq box[q+1]->v[j] and
  *              box[q]->v[k] \geq box[q+1]->v[k]
  */
-bool box_sort(const Box &a, const Box &b, int index) {
-  int j, k;
-  if (index == 0) {
-    j = 1; k = 2;
-  } else if (index == 1) {
-    j = 0; k = 2;
-  } else {
-    j = 0; k = 1;
+template<int N>
+inline bool box_sort(const Box<N> * a, const Box<N> * b, int index) {
+  const int j = other(index, 0);
+  const int k = other(index, 1);
+  bool same = true;
+  for(int i = 0; i < N; ++i) {
+    same &= (a->u[i] == b->u[i]);
   }
-
-  if ((a.u[0] == b.u[0]) && (a.u[1] == b.u[1]) && (a.u[2] == b.u[2])) {
-    if ((a.v[j] <= b.v[j]) && (a.v[k] >= b.v[k])) {
-      return true;
-    } else if ((b.v[j] <= a.v[j]) && (b.v[k] >= a.v[k])) {
-      return false;
-    } else {
-      // TODO Bad?
-      return false;
-    }
-  }
-  if ((a.u[j] <= b.u[j]) && (a.u[k] >= b.u[k])) {
-    return true;
-  } else if ((b.u[j] <= a.u[j]) && (b.u[k] >= a.u[k])) {
-    return false;
-  } else {
-    // TODO bad?
-    return false;
+  if (same) {
+    return (a->v[j] <= b->v[j]) && (a->v[k] >= b->v[k]);
   }
-  return false;
+  return (a->u[j] <= b->u[j]) && (a->u[k] >= b->u[k]);
 }
 
 
+/**
+ * A box handed to a worker, together with the known solutions on its edge
+ * (only collected when warm-starting).
+ */
+template<int N>
+struct Job {
+  Box<N> * box;
+  std::vector<Result<N> *> known;
+};
+
+
+/**
+ * Workers only solve boxes. They take Jobs from a shared work queue and push
+ * each Result onto a lock-free queue. A single coordinator thread owns the
+ * box decomposition: it applies results (splitting boxes and updating
+ * solutions), and refills the work queue from the boxes waiting to be solved.
+ * No worker ever waits while boxes are being split.
+ *
+ * N is the number of objectives.
+ */
+template<int N>
 class JobServer {
   public:
-    explicit JobServer(size_t threads, CPXLONG *utopia_, Sense sense_, std::string name_);
+    /**
+     * solvers_ are solvers already opened on problem_ (see Solver::open()),
+     * with or without their utopia point set. Workers take these over before
+     * opening any more, and the server deletes any left over.
+     */
+    explicit JobServer(size_t threads, CPXLONG *utopia_, const Problem & problem_,
+        std::vector<Solver *> solvers_, bool warmStart_, bool harvestPool_,
+        Backend backend_, Policy policy, StreamWriter * stream_,
+        Trace * trace_);
+
+    /**
+     * Answer boxes from a recording instead of solving them, waiting for
+     * latency times each recorded solve time (0 to answer at once).
+     */
+    JobServer(size_t threads, Replay<N> * replay_, double latency,
+        Policy policy, StreamWriter * stream_, Trace * trace_);
     ~JobServer();
 
-    void q(Box * b);
+    void q(Box<N> * b);
     void wait();
 
-    std::list<Result *> getSolutions();
+    /**
+     * Add a point that is already known to be nondominated, e.g. from a
+     * checkpoint. The server takes ownership of r. Must be called before
+     * the first call to q().
+     */
+    void seed(Result<N> * r);
+
+    /**
+     * Add a point found before the run started, in a box of its own, as if a
+     * worker had found it: it splits every box given to the next call of q()
+     * that contains it. The server takes ownership of r and its box. Must be
+     * called before that call to q().
+     */
+    void found(Result<N> * r);
+
+    /**
+     * Write a checkpoint to filename whenever at least interval seconds
+     * have passed since the last one. Must be called before the first call
+     * to q().
+     */
+    void checkpointTo(const std::string & filename, double interval);
+
+    /**
+     * Share cores between the local workers' solves, rather than giving
+     * each solve one thread. When there are fewer boxes than workers, each
+     * solve that starts takes a share of the cores not in use, and leaves
+     * enough for the boxes about to be taken by other workers. Every solve
+     * gets at least one thread, and its cores are returned when it ends. If
+     * deterministic, each solve instead gets the same fixed share of the
+     * cores, and CPLEX runs in deterministic parallel mode, so that a box's
+     * answer never depends on timing. Must be called before the first call
+     * to q().
+     */
+    void shareCores(int cores_, bool deterministic_);
+
+    /**
+     * Record the answer to every box solved, so that the run can be
+     * replayed. Returns false if filename can't be written.
+     */
+    bool recordTo(const std::string & filename);
+
+    /**
+     * Accept worker processes on address (see remote.hpp), and hand them
+     * boxes alongside the local workers. Returns false if the address can't
+     * be listened on.
+     */
+    bool listen(const std::string & address);
+
+    /**
+     * Every point found, sorted lexicographically from largest to smallest.
+     */
+    std::list<Result<N> *> getSolutions();
+
+    /**
+     * How many solves were interrupted because their box was split while
+     * they ran.
+     */
+    int cancelledCount() const;
+
+    /**
+     * Wall-clock time spent in solves that were then interrupted.
+     */
+    double cancelledSeconds() const;
+
+    /**
+     * An estimate of the solve time saved by interrupting solves: for each
+     * interrupted solve, how much less time it took than the average
+     * completed solve.
+     */
+    double savedSeconds() const;
 
   private:
-    std::list<Box *> waiting;
-    std::list<Box *> runningBoxes;
-    // How many threads are actively doing things, rather than waiting
-    std::atomic<int> running;
-    std::list<Result *> solutions;
-    std::vector<std::thread> workers;
-    std::mutex queue_mutex;
-    std::mutex server_mutex;
-    std::condition_variable condition;
+    JobServer(size_t threads, CPXLONG * utopia_, Sense sense_,
+        const std::string & name_, const Problem * problem_,
+        std::vector<Solver *> solvers_, Replay<N> * replay_, double latency,
+        bool warmStart_, bool harvestPool_, Backend backend_, Policy policy,
+        StreamWriter * stream_, Trace * trace_);
+
+    /**
+     * The main loop of each worker thread.
+     */
+    void work();
+
+    /**
+     * Take the next job, waiting for one if necessary. Returns false when
+     * the server is stopping. Local workers pass share, which is set to the
+     * number of threads to solve the job with; these must be given back
+     * with releaseCores().
+     */
+    bool nextJob(Job<N> & job, int * share = nullptr);
+
+    /**
+     * Return the cores used by a solve that has ended.
+     */
+    void releaseCores(int share);
+
+    /**
+     * Hand a result to the coordinator.
+     */
+    void report(Result<N> * res);
+
+    /**
+     * A result for a box that was split before it was solved.
+     */
+    Result<N> * skipped(Box<N> * box);
+
+    /**
+     * What came of a box, for the trace.
+     */
+    static const char * outcome(Result<N> * res);
+
+    /**
+     * Accept connections from worker processes.
+     */
+    void acceptWorkers();
+
+    /**
+     * Serve one worker process: send it boxes and report what it finds.
+     */
+    void remoteWork(int fd);
+
+    /**
+     * The main loop of the coordinator thread.
+     */
+    void coordinate();
+
+    /**
+     * Apply a result from a worker, freeing the box it came from. Only called
+     * by the coordinator.
+     */
+    void apply(Result<N> * res);
+
+    /**
+     * Add the point in res, and any further points found with it, to the
+     * solutions, and split the boxes that contain them. Points that are
+     * already known are freed. Only called by the coordinator.
+     */
+    void addPoints(Result<N> * res);
+
+    /**
+     * Move boxes from waiting to the work queue, so that at most twice as
+     * many boxes as there are workers are handed out at once. Only called by
+     * the coordinator.
+     */
+    void publish();
+
+    /**
+     * Write a checkpoint if one is due. Only called by the coordinator.
+     */
+    void checkpoint();
+
+    /**
+     * Apply a new nondominated point: split every waiting and running box
+     * that contains it (GenerateNewBoxesVsplit), update the new boxes
+     * (UpdateIndividualSubsets) and queue them. Only called by the
+     * coordinator.
+     */
+    void split(const CPXLONG * soln);
+
+    // The following are only touched by the coordinator.
+    // Boxes waiting to be handed out, in the order given by the scheduling
+    // policy. Boxes that are split while they wait stay here, marked done,
+    // until publish() reaches them.
+    Scheduler<N> * waiting;
+    // Every box that is waiting or running and not yet split.
+    BoxIndex<N> boxes;
+    // Every point found so far.
+    Archive<N> solutions;
+    // Boxes handed to workers whose results have not been applied yet.
+    size_t outstanding;
+    // Scratch space for split().
+    std::vector<Box<N> *> sets[N];
+    std::vector<Box<N> *> affected;
+    // Counts and times of completed and interrupted solves.
+    int completed;
+    double completedSeconds;
+    std::vector<double> cancelled;
+
+    // The work queue, shared by the workers and the coordinator.
+    std::deque<Job<N>> ready;
+    std::mutex ready_mutex;
+    std::condition_variable ready_condition;
+    // The cores shared between local solves (0 to use one thread for each),
+    // and how they are shared; see shareCores(). busyCores and idleWorkers
+    // are guarded by ready_mutex.
+    int cores;
+    bool deterministic;
+    int busyCores;
+    size_t idleWorkers;
+
+    // Results from the workers, waiting for the coordinator.
+    ResultQueue<N> results;
+    // results_mutex guards incoming and finished, and is what the coordinator
+    // sleeps on. Workers only take it to wake a sleeping coordinator.
+    std::mutex results_mutex;
+    std::condition_variable results_condition;
+    std::atomic<bool> coordinatorSleeping;
+    // Set when a worker process connects or disconnects, so that the
+    // coordinator hands out more or fewer boxes.
+    bool workersChanged;
+    // Boxes given to q(), not yet seen by the coordinator.
+    std::list<Box<N> *> incoming;
+    // Points given to found(), applied along with the next incoming boxes.
+    std::vector<Result<N> *> foundPoints;
+    // Whether every queued box has been solved.
+    bool finished;
     std::condition_variable server_condition;
-    bool stop;
+
+    std::vector<std::thread> workers;
+    std::thread coordinator;
+    size_t threads;
+    // The socket worker processes connect to, or -1, and the threads serving
+    // them.
+    int listenFd;
+    std::thread acceptor;
+    std::vector<std::thread> remotes;
+    std::atomic<size_t> remoteWorkers;
+    std::atomic<bool> stop;
     CPXLONG *utopia;
-    int objcnt;
     Sense sense;
     std::string name;
+    // The master problem, which workers clone into their own sessions, or
+    // nullptr when replaying.
+    const Problem * problem;
+    // Solvers opened before the server started, waiting for a worker.
+    std::vector<Solver *> spare;
+    std::mutex spare_mutex;
+    // Where workers take answers from instead of solving, or nullptr, and
+    // how much of each recorded solve time they wait for.
+    Replay<N> * replay;
+    double replayLatency;
+    // Where to record answers to boxes, or nullptr.
+    Recorder<N> * recorder;
+    // Whether to keep decision vectors of solutions, and use them as MIP
+    // starts for boxes that contain them.
+    bool warmStart;
+    // Whether workers look for further nondominated points in the CPLEX
+    // solution pool after each solve.
+    bool harvestPool;
+    // Which solver workers use.
+    Backend backend;
+    // Where to write each new point as it is found, or nullptr.
+    StreamWriter * stream;
+    // Where to record what each thread spends its time on, or nullptr.
+    Trace * trace;
+    // Where and how often to write checkpoints. checkpointFile is empty if
+    // checkpoints are not wanted.
+    std::string checkpointFile;
+    double checkpointInterval;
+    std::chrono::steady_clock::time_point lastCheckpoint;
 
 };
 
-inline JobServer::JobServer(size_t threads, CPXLONG *utopia_, Sense sense_, std::string name_) : running(0),
-  queue_mutex(), server_mutex(), stop(false), utopia(utopia_), objcnt(3), sense(sense_), name(name_) {
+template<int N>
+inline JobServer<N>::JobServer(size_t threads_, CPXLONG *utopia_, const Problem & problem_,
+    std::vector<Solver *> solvers_, bool warmStart_, bool harvestPool_,
+    Backend backend_, Policy policy, StreamWriter * stream_, Trace * trace_) :
+  JobServer(threads_, utopia_, problem_.objsen, problem_.filename(), &problem_,
+      std::move(solvers_), nullptr, 0, warmStart_, harvestPool_, backend_,
+      policy, stream_, trace_) {
+}
+
+template<int N>
+inline JobServer<N>::JobServer(size_t threads_, Replay<N> * replay_,
+    double latency, Policy policy, StreamWriter * stream_, Trace * trace_) :
+  JobServer(threads_, replay_->utopia, replay_->sense, "replay", nullptr,
+      std::vector<Solver *>(), replay_, latency, false, false, CPLEX, policy,
+      stream_, trace_) {
+}
+
+template<int N>
+inline JobServer<N>::JobServer(size_t threads_, CPXLONG * utopia_,
+    Sense sense_, const std::string & name_, const Problem * problem_,
+    std::vector<Solver *> solvers_, Replay<N> * replay_, double latency,
+    bool warmStart_, bool harvestPool_, Backend backend_, Policy policy,
+    StreamWriter * stream_, Trace * trace_) :
+  waiting(Scheduler<N>::create(policy, sense_, utopia_)),
+  boxes(sense_), solutions(sense_),
+  outstanding(0), completed(0), completedSeconds(0),
+  cores(0), deterministic(true), busyCores(0), idleWorkers(0),
+  coordinatorSleeping(false), workersChanged(false), finished(true),
+  threads(threads_), listenFd(-1), remoteWorkers(0), stop(false), utopia(utopia_),
+  sense(sense_), name(name_), problem(problem_), spare(std::move(solvers_)),
+  replay(replay_),
+  replayLatency(latency), recorder(nullptr),
+  warmStart(warmStart_), harvestPool(harvestPool_), backend(backend_),
+  stream(stream_),
+  trace(trace_), checkpointInterval(0), lastCheckpoint(std::chrono::steady_clock::now()) {
   for(size_t t = 0; t < threads; ++t) {
-    workers.emplace_back(
-      [this] {
-        for (;;) {
-          Box * nextBox;
-          {
-            std::unique_lock<std::mutex> lock(this->queue_mutex);
-            this->condition.wait(lock,
-                [this]{ return this->stop || !this->waiting.empty(); });
-            if (this->stop && this->waiting.empty()) {
-              return;
-            }
-            running += 1;
-            nextBox = this->waiting.front();
-            this->waiting.pop_front();
-            this->runningBoxes.push_back(nextBox);
-          }
-          BoxFinder finder(name, objcnt, sense, this, nextBox, utopia);
-          Result * res = finder();
-          {
-            std::unique_lock<std::mutex> lock(this->queue_mutex);
-            if (res->soln[0] == res->soln[1] &&
-                res->soln[1] == res->soln[2] &&
-                res->soln[0] == -1) {
-              this->runningBoxes.erase(std::remove(runningBoxes.begin(), runningBoxes.end(),
-                    nextBox), runningBoxes.end());
-              delete nextBox;
-              delete res;
-            } else {
-              solutions.push_back(res);
-              // First run GenerateNewBoxesVsplit
-              // Create the set containing the 3 sets S_i
-              std::vector<std::vector<Box *>> sets;
-              // Create the 3 sets S_i
-              for(int i = 0; i < 3; ++i) {
-                sets.emplace_back();
-              }
-              // We run the following loop over every box in waiting, and later
-              // over every box in runningBoxes. We need this, as we need to a
-              // certain level of consistency between the 'v' values of the
-              // boxes which could otherwise be broken if we remove multiple
-              // boxes and then split one of them.
-              //
-              std::list<Box *> toDelete;
-              for(auto b: waiting) {
-                // Line 30
-                if (((sense == MIN) && (! b->less_than_u(res->soln))) ||
-                    ((sense == MAX) && (! b->greater_than_u(res->soln)))) {
-                  continue;
-                }
-                // line 31
-                for(int i = 0; i < 3; ++i) {
-                  // Line 32
-                  if (((sense == MIN) && (res->soln[i] >= b->v[i]) && (res->soln[i] > utopia[i])) ||
-                      ((sense == MAX) && (res->soln[i] <= b->v[i]) && (res->soln[i] < utopia[i]))) {
-                    // Line 33
-                    auto b_i = new Box(b);
-                    // Line 34
-                    b_i->u[i] = res->soln[i];
-                    // Line 35
-                    sets[i].push_back(b_i);
-#ifdef DEBUG
-                    debug_mutex.lock();
-                    std::cout << "Split in " << i << " to make " << b_i->str() << std::endl;
-                    debug_mutex.unlock();
-#endif
-                  }
-                }
-                // Line 36
-                // Delete a box we're iterating over. This is hard while iterating, so
-                // mark it as "to delete"
-                b->done = true;
-                toDelete.push_back(b);
-              }
-              for(auto b: runningBoxes) {
-                // Line 30
-                if (((sense == MIN) && (! b->less_than_u(res->soln))) ||
-                    ((sense == MAX) && (! b->greater_than_u(res->soln)))) {
-                  continue;
-                }
-                // line 31
-                for(int i = 0; i < 3; ++i) {
-                  // Line 32
-                  if (((sense == MIN) && (res->soln[i] >= b->v[i]) && (res->soln[i] > utopia[i])) ||
-                      ((sense == MAX) && (res->soln[i] <= b->v[i]) && (res->soln[i] < utopia[i]))) {
-                    // Line 33
-                    auto b_i = new Box(b);
-                    // Line 34
-                    b_i->u[i] = res->soln[i];
-                    // Line 35
-                    sets[i].push_back(b_i);
+    workers.emplace_back(&JobServer<N>::work, this);
+  }
+  coordinator = std::thread(&JobServer<N>::coordinate, this);
+}
+
+template<int N>
+inline void JobServer<N>::work() {
+  // Each worker keeps one solver for its whole lifetime, rather than opening
+  // CPLEX and reading the problem for every box. The solver's model is
+  // cloned from the master problem in memory (usually while the utopia point
+  // was found, see Solver::open()), and the scalarisation is built once,
+  // here. Replaying needs no solver at all.
+  Solver * solver = nullptr;
+  if (! replay) {
+    {
+      std::unique_lock<std::mutex> lock(spare_mutex);
+      if (! spare.empty()) {
+        solver = spare.back();
+        spare.pop_back();
+      }
+    }
+    if (solver) {
+      if (! solver->hasUtopia()) {
+        solver->setUtopia(utopia);
+      }
+    } else {
+      solver = Solver::create(backend, *problem, utopia);
+    }
+  }
+  TraceBuffer * buffer = trace ? trace->thread("worker") : nullptr;
+  Job<N> job;
+  int threadsUsed = 1;
+  for (;;) {
+    auto waitStart = TraceClock::now();
+    int share = 1;
+    if (! nextJob(job, &share)) {
+      delete solver;
+      return;
+    }
+    if (solver && (share != threadsUsed)) {
+      solver->setThreads(share);
+      solver->setDeterministic(deterministic);
+      threadsUsed = share;
+    }
+    auto solveStart = TraceClock::now();
+    Result<N> * res;
+    if (job.box->done) {
+      res = skipped(job.box);
+    } else if (replay) {
+      res = replay->solve(job.box, replayLatency);
+      ipcount++;
+    } else {
+      BoxFinder<N> finder(name, sense, this, *solver, job.box,
+          std::move(job.known), warmStart, harvestPool, buffer);
+      res = finder();
+    }
+    if (buffer) {
+      buffer->complete("wait", waitStart, solveStart);
+      buffer->complete("solve", solveStart, TraceClock::now(),
+          traceArgs(job.box->u, N, outcome(res)));
+    }
+    report(res);
+    releaseCores(share);
+  }
+}
+
+template<int N>
+inline bool JobServer<N>::nextJob(Job<N> & job, int * share) {
+  std::unique_lock<std::mutex> lock(ready_mutex);
+  if (share) {
+    idleWorkers += 1;
+  }
+  ready_condition.wait(lock, [this]{ return stop || !ready.empty(); });
+  if (share) {
+    idleWorkers -= 1;
+  }
+  if (stop) {
+    return false;
+  }
+  job = std::move(ready.front());
+  ready.pop_front();
+  if (share && (cores > 0)) {
+    if (deterministic) {
+      *share = std::max(cores / static_cast<int>(threads), 1);
+    } else {
+      // Leave a fair share of the free cores for each box that an idle
+      // worker is about to take. Once every worker is busy, new solves get
+      // one thread, so the cores held by wide solves are reclaimed as they
+      // end.
+      int starting = static_cast<int>(std::min(ready.size(), idleWorkers));
+      *share = std::max((cores - busyCores) / (1 + starting), 1);
+    }
+    busyCores += *share;
+  }
+  return true;
+}
+
+template<int N>
+inline void JobServer<N>::releaseCores(int share) {
+  if (cores == 0) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(ready_mutex);
+  busyCores -= share;
+}
+
+template<int N>
+inline void JobServer<N>::report(Result<N> * res) {
+  results.push(res);
+  if (coordinatorSleeping) {
+    std::unique_lock<std::mutex> lock(results_mutex);
+    results_condition.notify_one();
+  }
+}
+
+template<int N>
+inline Result<N> * JobServer<N>::skipped(Box<N> * box) {
+  // Split since it was handed out, so there is nothing to find.
+  CPXLONG none[N];
+  for(int i = 0; i < N; ++i) {
+    none[i] = -1;
+  }
+  return new Result<N>(box, none);
+}
+
+template<int N>
+inline const char * JobServer<N>::outcome(Result<N> * res) {
+  if (! res->isEmpty()) {
+    return "point";
+  }
+  if (res->cancelled || res->box()->done) {
+    return "obsolete";
+  }
+  return "infeasible";
+}
+
+template<int N>
+inline bool JobServer<N>::listen(const std::string & address) {
+  listenFd = listenOn(address);
+  if (listenFd < 0) {
+    return false;
+  }
+  acceptor = std::thread(&JobServer<N>::acceptWorkers, this);
+  return true;
+}
+
+template<int N>
+inline void JobServer<N>::acceptWorkers() {
+  for (;;) {
+    int fd = ::accept(listenFd, nullptr, nullptr);
+    if (fd < 0) {
+      if (stop) {
+        return;
+      }
+      continue;
+    }
+    CPXLONG hello[3 + N];
+    hello[0] = REMOTE_MAGIC;
+    hello[1] = N;
+    hello[2] = sense;
+    for(int i = 0; i < N; ++i) {
+      hello[3 + i] = utopia[i];
+    }
+    CPXLONG ready;
+    if (! sendWords(fd, hello, 3 + N) || ! recvWords(fd, &ready, 1) ||
+        (ready != REMOTE_MAGIC)) {
+      closeConnection(fd);
+      continue;
+    }
+    remoteWorkers += 1;
+    remotes.emplace_back(&JobServer<N>::remoteWork, this, fd);
+    {
+      std::unique_lock<std::mutex> lock(results_mutex);
+      workersChanged = true;
+    }
+    results_condition.notify_one();
+  }
+}
+
+template<int N>
+inline void JobServer<N>::remoteWork(int fd) {
+  TraceBuffer * buffer = trace ? trace->thread("remote worker") : nullptr;
+  Job<N> job;
+  std::vector<CPXLONG> reply(N);
+  while (nextJob(job)) {
+    if (job.box->done) {
+      report(skipped(job.box));
+      continue;
+    }
+    CPXLONG request[1 + N];
+    request[0] = MSG_BOX;
+    for(int i = 0; i < N; ++i) {
+      request[1 + i] = job.box->u[i];
+    }
+    auto start = std::chrono::steady_clock::now();
+    CPXLONG header[2];
+    CPXLONG soln[N];
+    CPXLONG extras = 0;
+    bool ok = sendWords(fd, request, 1 + N) && recvWords(fd, header, 2) &&
+              recvWords(fd, soln, N) && recvWords(fd, &extras, 1);
+    // Counts come straight off the socket, so a reply with impossible ones
+    // is treated like a lost connection.
+    ok = ok && (header[1] >= 0) && (extras >= 0) &&
+         (extras <= REMOTE_MAX_EXTRAS);
+    if (ok) {
+      reply.resize(extras * N);
+      ok = recvWords(fd, reply.data(), reply.size());
+    }
+    if (! ok) {
+      // The worker has gone, or is broken. Its box must be solved again, so
+      // return it as cancelled: apply() puts it back in the queue.
+      std::cerr << "Lost a remote worker." << std::endl;
+      Result<N> * res = skipped(job.box);
+      res->cancelled = true;
+      report(res);
+      remoteWorkers -= 1;
+      {
+        std::unique_lock<std::mutex> lock(results_mutex);
+        workersChanged = true;
+      }
+      results_condition.notify_one();
+      closeConnection(fd);
+      return;
+    }
+    ipcount += header[1];
+    Result<N> * res;
+    if (header[0] == REPLY_EMPTY) {
+      res = skipped(job.box);
+    } else {
+      res = new Result<N>(job.box, soln);
+      for(CPXLONG k = 0; k < extras; ++k) {
+        res->extra.push_back(new Result<N>(nullptr, reply.data() + k * N));
+      }
+    }
+    auto end = std::chrono::steady_clock::now();
+    res->seconds = std::chrono::duration<double>(end - start).count();
+    if (buffer) {
+      buffer->complete("solve", start, end,
+          traceArgs(job.box->u, N, outcome(res)));
+    }
+    report(res);
+  }
+  CPXLONG bye = MSG_STOP;
+  sendWords(fd, &bye, 1);
+  closeConnection(fd);
+}
+
+template<int N>
+inline void JobServer<N>::coordinate() {
+  TraceBuffer * buffer = trace ? trace->thread("coordinator") : nullptr;
+  std::vector<Result<N> *> points;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(results_mutex);
+      if (waiting->empty() && (outstanding == 0) && incoming.empty() &&
+          !finished) {
+        finished = true;
+        server_condition.notify_all();
+      }
+      coordinatorSleeping = true;
+      results_condition.wait(lock, [this]{
+          return stop || !results.empty() || !incoming.empty() ||
+                 workersChanged; });
+      coordinatorSleeping = false;
+      workersChanged = false;
+      if (stop) {
+        return;
+      }
+      if (! incoming.empty()) {
+        points.swap(foundPoints);
+      }
+      for(auto b: incoming) {
+        waiting->push(b);
+        boxes.insert(b);
+      }
+      incoming.clear();
+    }
+    for(auto res: points) {
+      Box<N> * box = res->box();
+      if (recorder) {
+        recorder->write(res);
+      }
+      addPoints(res);
+      delete box;
+    }
+    points.clear();
+    Result<N> * res = results.popAll();
+    while (res != nullptr) {
+      Result<N> * next = res->next;
+      res->next = nullptr;
+      if (recorder && ! res->cancelled && (res->seconds > 0)) {
+        // Skipped boxes were never solved, so have no answer to record.
+        recorder->write(res);
+      }
+      if (buffer) {
+        // apply() frees the box, so describe it first.
+        std::string args = traceArgs(res->box()->u, N, outcome(res));
+        auto start = TraceClock::now();
+        apply(res);
+        buffer->complete("split", start, TraceClock::now(), args);
+      } else {
+        apply(res);
+      }
+      outstanding -= 1;
+      res = next;
+    }
+    auto start = TraceClock::now();
+    publish();
+    if (buffer) {
+      buffer->complete("publish", start, TraceClock::now());
+    }
+    checkpoint();
+  }
+}
+
+template<int N>
+inline void JobServer<N>::checkpoint() {
+  if (checkpointFile.empty()) {
+    return;
+  }
+  auto now = std::chrono::steady_clock::now();
+  if (std::chrono::duration<double>(now - lastCheckpoint).count() <
+      checkpointInterval) {
+    return;
+  }
+  lastCheckpoint = now;
+  Checkpoint<N> ck;
+  ck.sense = sense;
+  ck.ipcount = ipcount;
+  for(int i = 0; i < N; ++i) {
+    ck.utopia[i] = utopia[i];
+  }
+  std::vector<Result<N> *> points;
+  solutions.all(points);
+  ck.points.resize(points.size());
+  for(size_t k = 0; k < points.size(); ++k) {
+    for(int i = 0; i < N; ++i) {
+      ck.points[k].soln[i] = points[k]->soln[i];
+    }
+  }
+  // Every box that is waiting or running, and not yet split, is in the
+  // index. Running boxes go back on the queue when the run is resumed.
+  std::vector<Box<N> *> live;
+  boxes.all(live);
+  ck.boxes.resize(live.size());
+  for(size_t k = 0; k < live.size(); ++k) {
+    for(int i = 0; i < N; ++i) {
+      ck.boxes[k].u[i] = live[k]->u[i];
+      ck.boxes[k].v[i] = live[k]->v[i];
+    }
+    ck.boxes[k].depth = live[k]->depth;
+  }
+  if (! ck.write(checkpointFile)) {
+    std::cerr << "Failed to write checkpoint " << checkpointFile << std::endl;
+  }
+}
+
+template<int N>
+inline void JobServer<N>::apply(Result<N> * res) {
+  Box<N> * box = res->box();
+  if (res->cancelled && ! box->done) {
+    // Only a lost worker process cancels a box that is still live. It is
+    // still in the index, so only needs to be queued again.
+    waiting->push(box);
+    delete res;
+    return;
+  }
+  if (res->cancelled) {
+    cancelled.push_back(res->seconds);
+  } else if (res->seconds > 0) {
+    // Boxes skipped by the worker were never solved, and took no time.
+    completed += 1;
+    completedSeconds += res->seconds;
+  }
+  if (res->isEmpty()) {
+    // A box that was split before it was solved was skipped by the worker,
+    // so tells us nothing about the policy.
+    if (! box->done) {
+      waiting->solved(box, false);
+    }
+    boxes.erase(box);
+    delete box;
+    delete res;
+    return;
+  }
+  waiting->solved(box, true);
+  addPoints(res);
+  // box contains res, so split() has already taken it out of the index.
+  boxes.erase(box);
+  delete box;
+}
+
+template<int N>
+inline void JobServer<N>::addPoints(Result<N> * res) {
+  // Any further points found in the same solve have already been proven
+  // nondominated by the worker, but another worker may have found them too.
+  std::vector<Result<N> *> extra;
+  extra.swap(res->extra);
+  if (solutions.insert(res)) {
+    if (stream) {
+      stream->write(res->soln, N, ipcount);
+    }
+    split(res->soln);
+  } else {
+    // Every box containing a known point has already been split, so there
+    // is nothing more to do with it.
+    delete res;
+  }
+  for(auto r: extra) {
+    if (! solutions.insert(r)) {
+      delete r;
+      continue;
+    }
+    if (stream) {
+      stream->write(r->soln, N, ipcount);
+    }
+    split(r->soln);
+  }
+}
+
+template<int N>
+inline void JobServer<N>::publish() {
+  std::vector<Job<N>> batch;
+  size_t limit = 2 * (threads + remoteWorkers);
+  while (!waiting->empty() && (outstanding + batch.size() < limit)) {
+    Box<N> * b = waiting->pop();
+    if (b->done) {
+      // This box was split while it was waiting. It has already been removed
+      // from the index, so we just need to free it.
+      delete b;
+      continue;
+    }
+    Job<N> job;
+    job.box = b;
+    // Results in solutions are never modified or deleted while we run, so
+    // the worker can read them after we hand them over.
+    if (warmStart) {
+      solutions.bordering(b, job.known);
+    }
+    batch.push_back(std::move(job));
+  }
+  if (batch.empty()) {
+    return;
+  }
+  outstanding += batch.size();
+  {
+    std::unique_lock<std::mutex> lock(ready_mutex);
+    for(auto & job: batch) {
+      ready.push_back(std::move(job));
+    }
+  }
+  if (batch.size() == 1) {
+    ready_condition.notify_one();
+  } else {
+    ready_condition.notify_all();
+  }
+}
+
+template<int N>
+inline void JobServer<N>::split(const CPXLONG * soln) {
+  // First run GenerateNewBoxesVsplit
+  // The choice of j and k below is only defined for 3 objectives.
+  static_assert(N == 3, "Box splitting is only implemented for 3 objectives");
+  // The N sets S_i, and the boxes affected, are kept between calls so that
+  // their storage is reused.
+  for(int i = 0; i < N; ++i) {
+    sets[i].clear();
+  }
+  affected.clear();
+  // Find every waiting or running box that contains the new point. We
+  // collect them all before changing anything, as we need to a certain level
+  // of consistency between the 'v' values of the boxes which could otherwise
+  // be broken if we remove multiple boxes and then split one of them.
+  boxes.containing(soln, affected);
+  // Line 30 is the test done by boxes.containing()
+  for(auto b: affected) {
+    // line 31
+    for(int i = 0; i < N; ++i) {
+      // Line 32
+      if (((sense == MIN) && (soln[i] >= b->v[i]) && (soln[i] > utopia[i])) ||
+          ((sense == MAX) && (soln[i] <= b->v[i]) && (soln[i] < utopia[i]))) {
+        // Line 33
+        auto b_i = new Box<N>(b);
+        // Line 34
+        b_i->u[i] = soln[i];
+        // Line 35
+        sets[i].push_back(b_i);
 #ifdef DEBUG
-                    debug_mutex.lock();
-                    std::cout << "Split in " << i << " to make " << b_i->str() << std::endl;
-                    debug_mutex.unlock();
+        debug_mutex.lock();
+        std::cout << "Split in " << i << " to make " << b_i->str() << std::endl;
+        debug_mutex.unlock();
 #endif
-                  }
-                }
-                // Line 36
-                // Delete a box we're iterating over. This is hard while iterating, so
-                // mark it as "to delete"
-                b->done = true;
-              }
-              // Rest of line 36. Now we remove all the completed boxes, in one go.
-              waiting.erase(std::remove_if(waiting.begin(), waiting.end(),
-                  [](Box * b){return b->done;}), waiting.end());
-              for(auto b: toDelete) {
-                delete b;
-              }
-
-              // Note that running boxes will always be deleted by the task
-              // running them, so we don't need to call delete on them.
-              runningBoxes.erase(std::remove_if(runningBoxes.begin(),
-                    runningBoxes.end(), [](Box * b){return b->done;}),
-                    runningBoxes.end());
-              delete nextBox;
-
-              // Next step, UpdateIndividualSubsets
-              for(int i = 0; i < 3; ++i) {
-                if (sets[i].empty()) {
-                  continue;
-                }
+      }
+    }
+  }
+  // Line 36. The boxes leave the index now, but are only freed later: a
+  // waiting box when publish() reaches it, and a running box when its result
+  // comes back.
+  // Any of these boxes that is being solved now can only find points we
+  // will look for again in the new boxes, so stop it.
+  for(auto b: affected) {
+    b->done = true;
+    b->abort = 1;
+    boxes.erase(b);
+  }
+
+  // Next step, UpdateIndividualSubsets
+  for(int i = 0; i < N; ++i) {
+    if (sets[i].empty()) {
+      continue;
+    }
 #ifdef DEBUG
-                debug_mutex.lock();
-                std::cout << "UpdateIndividualSubsets in " << i << " has " << sets[i].size() << " elements." << std::endl;
-                debug_mutex.unlock();
+    debug_mutex.lock();
+    std::cout << "UpdateIndividualSubsets in " << i << " has " << sets[i].size() << " elements." << std::endl;
+    debug_mutex.unlock();
 #endif
-                int j, k;
-                if (i == 0) {
-                  j = 1; k = 2;
-                } else if (i == 1) {
-                  j = 0; k = 2;
-                } else {
-                  j = 0; k = 1;
-                }
-                // Lines 45 to 49. Also see box_sort function at start of this file
-                if (sense == MIN) {
-                  auto sort_fn = std::bind(box_sort, std::placeholders::_1, std::placeholders::_2, i);
-                  std::sort(sets[i].begin(), sets[i].end(), sort_fn);
-                } else {
-                  // Maximising, negate sort function with a lambda.
-                  auto sort_fn = std::bind(box_sort, std::placeholders::_1, std::placeholders::_2, i);
-                  std::sort(sets[i].begin(), sets[i].end(), [sort_fn](Box *a, Box *b) {return !sort_fn(a,b);});
-                }
-                // Line 50
-                if (sense == MIN) {
-                  sets[i].front()->v[j] = res->soln[j];
-                  sets[i].back()->v[k] = res->soln[k];
-                } else {
-                  sets[i].back()->v[j] = res->soln[j];
-                  sets[i].front()->v[k] = res->soln[k];
-                }
-                // Line 51
-                for(auto it = sets[i].begin() + 1; it != sets[i].end(); ++it) {
-                  // Line 52
-                  if (sense == MIN) {
-                    (*it)->v[j] = (*(it-1))->u[j];
-                    (*(it-1))->v[k] = (*it)->u[k];
-                  } else {
-                    (*(it-1))->v[j] = (*it)->u[j];
-                    (*it)->v[k] = (*(it-1))->u[k];
-                  }
-                }
-                // Line 54
-                for(auto newbox: sets[i]) {
-                  waiting.push_back(newbox);
-                  condition.notify_one();
-                }
-              }
-            }
-          }
-          running -= 1;
-          server_condition.notify_one();
-        }
+    const int j = other(i, 0);
+    const int k = other(i, 1);
+    // Lines 45 to 49. Also see box_sort function at start of this file
+    if (sense == MIN) {
+      std::sort(sets[i].begin(), sets[i].end(), [i](Box<N> *a, Box<N> *b) {
+          return box_sort<N>(a, b, i); });
+    } else {
+      // Maximising, negate sort function.
+      std::sort(sets[i].begin(), sets[i].end(), [i](Box<N> *a, Box<N> *b) {
+          return !box_sort<N>(a, b, i); });
+    }
+    // Line 50
+    if (sense == MIN) {
+      sets[i].front()->v[j] = soln[j];
+      sets[i].back()->v[k] = soln[k];
+    } else {
+      sets[i].back()->v[j] = soln[j];
+      sets[i].front()->v[k] = soln[k];
+    }
+    // Line 51
+    for(auto it = sets[i].begin() + 1; it != sets[i].end(); ++it) {
+      // Line 52
+      if (sense == MIN) {
+        (*it)->v[j] = (*(it-1))->u[j];
+        (*(it-1))->v[k] = (*it)->u[k];
+      } else {
+        (*(it-1))->v[j] = (*it)->u[j];
+        (*it)->v[k] = (*(it-1))->u[k];
       }
-    );
+    }
+    // Line 54
+    for(auto newbox: sets[i]) {
+      waiting->push(newbox);
+      boxes.insert(newbox);
+    }
   }
 }
 
-inline JobServer::~JobServer() {
+template<int N>
+inline JobServer<N>::~JobServer() {
+  stop = true;
   {
-    std::unique_lock<std::mutex> lock(queue_mutex);
-    stop = true;
+    std::unique_lock<std::mutex> lock(ready_mutex);
   }
-  condition.notify_all();
+  ready_condition.notify_all();
+  {
+    std::unique_lock<std::mutex> lock(results_mutex);
+  }
+  results_condition.notify_all();
   for(std::thread &worker: workers) {
     worker.join();
   }
+  coordinator.join();
+  if (listenFd >= 0) {
+    shutdownListener(listenFd);
+    acceptor.join();
+  }
+  for(std::thread &remote: remotes) {
+    remote.join();
+  }
+  delete waiting;
+  delete recorder;
+  for(auto solver: spare) {
+    delete solver;
+  }
+  for(auto res: foundPoints) {
+    delete res->box();
+    delete res;
+  }
 }
 
-inline void JobServer::q(Box * b) {
+template<int N>
+inline void JobServer<N>::q(Box<N> * b) {
   {
-    std::unique_lock<std::mutex> lock(queue_mutex);
+    std::unique_lock<std::mutex> lock(results_mutex);
 
     // don't allow enqueueing after stopping the pool
     if (stop) {
         throw std::runtime_error("enqueue on stopped ThreadPool");
     }
-    this->waiting.push_back(b);
+    incoming.push_back(b);
+    finished = false;
   }
-  condition.notify_one();
+  results_condition.notify_one();
 }
 
-inline std::list<Result *> JobServer::getSolutions() {
-  return std::move(solutions);
+template<int N>
+inline void JobServer<N>::seed(Result<N> * r) {
+  if (! solutions.insert(r)) {
+    delete r;
+  }
+}
+
+template<int N>
+inline void JobServer<N>::found(Result<N> * r) {
+  std::unique_lock<std::mutex> lock(results_mutex);
+  foundPoints.push_back(r);
+}
+
+template<int N>
+inline void JobServer<N>::shareCores(int cores_, bool deterministic_) {
+  std::unique_lock<std::mutex> lock(ready_mutex);
+  cores = cores_;
+  deterministic = deterministic_;
+}
+
+template<int N>
+inline void JobServer<N>::checkpointTo(const std::string & filename,
+    double interval) {
+  checkpointFile = filename;
+  checkpointInterval = interval;
+}
+
+template<int N>
+inline bool JobServer<N>::recordTo(const std::string & filename) {
+  recorder = new Recorder<N>(filename, sense, utopia);
+  return recorder->good();
+}
+
+template<int N>
+inline std::list<Result<N> *> JobServer<N>::getSolutions() {
+  return solutions.take();
+}
+
+template<int N>
+inline int JobServer<N>::cancelledCount() const {
+  return cancelled.size();
+}
+
+template<int N>
+inline double JobServer<N>::cancelledSeconds() const {
+  double total = 0;
+  for(auto s: cancelled) {
+    total += s;
+  }
+  return total;
+}
+
+template<int N>
+inline double JobServer<N>::savedSeconds() const {
+  if (completed == 0) {
+    return 0;
+  }
+  double average = completedSeconds / completed;
+  double total = 0;
+  for(auto s: cancelled) {
+    total += std::max(0.0, average - s);
+  }
+  return total;
 }
 
-inline void JobServer::wait() {
-  std::unique_lock<std::mutex> lk(server_mutex);
-  this->server_condition.wait(lk,
-      [this]{ return (running == 0) && this->waiting.empty(); });
+template<int N>
+inline void JobServer<N>::wait() {
+  std::unique_lock<std::mutex> lk(results_mutex);
+  this->server_condition.wait(lk, [this]{ return finished; });
 }
 
 #endif /* JOBSERVER_H */
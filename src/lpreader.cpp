@@ -0,0 +1,973 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <ilcplex/cplexx.h>
+
+#include "lpreader.hpp"
+#include "model.hpp"
+
+namespace {
+constexpr double INF = std::numeric_limits<double>::infinity();
+
+bool endsWith(const char * s, const char * suffix) {
+  size_t len = strlen(s);
+  size_t slen = strlen(suffix);
+  return (len > slen) && (strcmp(s + len - slen, suffix) == 0);
+}
+
+bool iequals(const std::string & a, const char * b) {
+  size_t i = 0;
+  for(; (i < a.size()) && (b[i] != '\0'); ++i) {
+    if (tolower(static_cast<unsigned char>(a[i])) != b[i]) {
+      return false;
+    }
+  }
+  return (i == a.size()) && (b[i] == '\0');
+}
+
+/**
+ * Somewhere to read lines of text from.
+ */
+class LineSource {
+  public:
+    LineSource() : good_(false) { }
+    virtual ~LineSource() { }
+
+    /**
+     * Set [begin, end) to the next line, without its line ending. The line
+     * is only valid until the next call. Returns false at the end of the
+     * input, or on an error.
+     */
+    virtual bool getline(const char *& begin, const char *& end) = 0;
+
+    /**
+     * Whether the input was opened and, so far, read without error.
+     */
+    bool good() const { return good_; }
+
+  protected:
+    bool good_;
+};
+
+/**
+ * The lines of a memory-mapped file.
+ */
+class MappedFile : public LineSource {
+  public:
+    explicit MappedFile(const char * filename) : data_(nullptr), size_(0),
+        pos_(0) {
+      int fd = open(filename, O_RDONLY);
+      if (fd < 0) {
+        std::cerr << "Error: Cannot open " << filename << ": "
+          << strerror(errno) << std::endl;
+        return;
+      }
+      struct stat st;
+      if (fstat(fd, &st) != 0) {
+        std::cerr << "Error: Cannot read " << filename << ": "
+          << strerror(errno) << std::endl;
+        ::close(fd);
+        return;
+      }
+      size_ = st.st_size;
+      if (size_ > 0) {
+        void * map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+          std::cerr << "Error: Cannot map " << filename << ": "
+            << strerror(errno) << std::endl;
+          ::close(fd);
+          return;
+        }
+        madvise(map, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char *>(map);
+      }
+      ::close(fd);
+      good_ = true;
+    }
+
+    ~MappedFile() {
+      if (data_ != nullptr) {
+        munmap(const_cast<char *>(data_), size_);
+      }
+    }
+
+    bool getline(const char *& begin, const char *& end) override {
+      if (pos_ >= size_) {
+        return false;
+      }
+      begin = data_ + pos_;
+      const char * nl = static_cast<const char *>(memchr(begin, '\n',
+            size_ - pos_));
+      end = (nl == nullptr) ? data_ + size_ : nl;
+      pos_ = (end - data_) + 1;
+      if ((end > begin) && (end[-1] == '\r')) {
+        --end;
+      }
+      return true;
+    }
+
+  private:
+    const char * data_;
+    size_t size_;
+    size_t pos_;
+};
+
+/**
+ * The lines of input that arrives in chunks, such as from a decompressor.
+ * Only the current line, and what has been read after it, is kept.
+ */
+class StreamedFile : public LineSource {
+  public:
+    StreamedFile() : buf_(1 << 18), start_(0), end_(0), eof_(false) { }
+
+    bool getline(const char *& begin, const char *& end) override {
+      for(;;) {
+        char * data = buf_.data();
+        const char * nl = static_cast<const char *>(memchr(data + start_,
+              '\n', end_ - start_));
+        if ((nl == nullptr) && eof_) {
+          if (start_ == end_) {
+            return false;
+          }
+          nl = data + end_;
+        }
+        if (nl != nullptr) {
+          begin = data + start_;
+          end = nl;
+          start_ = std::min(end_, static_cast<size_t>(nl - data) + 1);
+          if ((end > begin) && (end[-1] == '\r')) {
+            --end;
+          }
+          return true;
+        }
+        // Keep the start of the line, and read more after it.
+        memmove(data, data + start_, end_ - start_);
+        end_ -= start_;
+        start_ = 0;
+        if (end_ == buf_.size()) {
+          buf_.resize(2 * buf_.size());
+        }
+        long got = fill(buf_.data() + end_, buf_.size() - end_);
+        if (got < 0) {
+          good_ = false;
+          return false;
+        }
+        eof_ = (got == 0);
+        end_ += got;
+      }
+    }
+
+  protected:
+    /**
+     * Read up to size bytes into dest. Returns how many were read, 0 at the
+     * end of the input, or -1 after printing an error.
+     */
+    virtual long fill(char * dest, size_t size) = 0;
+
+  private:
+    std::vector<char> buf_;
+    size_t start_;
+    size_t end_;
+    bool eof_;
+};
+
+#ifdef HAVE_ZLIB
+class GzipFile : public StreamedFile {
+  public:
+    explicit GzipFile(const char * filename) : filename_(filename) {
+      gz_ = gzopen(filename, "rb");
+      if (gz_ == nullptr) {
+        std::cerr << "Error: Cannot open " << filename << std::endl;
+        return;
+      }
+      gzbuffer(gz_, 1 << 17);
+      good_ = true;
+    }
+
+    ~GzipFile() {
+      if (gz_ != nullptr) {
+        gzclose(gz_);
+      }
+    }
+
+  protected:
+    long fill(char * dest, size_t size) override {
+      int got = gzread(gz_, dest, static_cast<unsigned>(std::min(size,
+              static_cast<size_t>(1 << 30))));
+      if (got < 0) {
+        int err;
+        std::cerr << "Error: Cannot decompress " << filename_ << ": "
+          << gzerror(gz_, &err) << std::endl;
+        return -1;
+      }
+      return got;
+    }
+
+  private:
+    const char * filename_;
+    gzFile gz_;
+};
+#endif
+
+#ifdef HAVE_ZSTD
+class ZstdFile : public StreamedFile {
+  public:
+    explicit ZstdFile(const char * filename) : filename_(filename),
+        stream_(nullptr), in_(ZSTD_DStreamInSize()), last_(0) {
+      input_.src = in_.data();
+      input_.size = 0;
+      input_.pos = 0;
+      file_ = fopen(filename, "rb");
+      if (file_ == nullptr) {
+        std::cerr << "Error: Cannot open " << filename << ": "
+          << strerror(errno) << std::endl;
+        return;
+      }
+      stream_ = ZSTD_createDStream();
+      ZSTD_initDStream(stream_);
+      good_ = true;
+    }
+
+    ~ZstdFile() {
+      if (stream_ != nullptr) {
+        ZSTD_freeDStream(stream_);
+      }
+      if (file_ != nullptr) {
+        fclose(file_);
+      }
+    }
+
+  protected:
+    long fill(char * dest, size_t size) override {
+      ZSTD_outBuffer output = { dest, size, 0 };
+      while (output.pos == 0) {
+        if (input_.pos == input_.size) {
+          input_.size = fread(in_.data(), 1, in_.size(), file_);
+          input_.pos = 0;
+          if (input_.size == 0) {
+            if (last_ != 0) {
+              std::cerr << "Error: " << filename_ << " is truncated."
+                << std::endl;
+              return -1;
+            }
+            return 0;
+          }
+        }
+        last_ = ZSTD_decompressStream(stream_, &output, &input_);
+        if (ZSTD_isError(last_)) {
+          std::cerr << "Error: Cannot decompress " << filename_ << ": "
+            << ZSTD_getErrorName(last_) << std::endl;
+          return -1;
+        }
+      }
+      return output.pos;
+    }
+
+  private:
+    const char * filename_;
+    FILE * file_;
+    ZSTD_DStream * stream_;
+    std::vector<char> in_;
+    ZSTD_inBuffer input_;
+    size_t last_;
+};
+#endif
+
+struct Token {
+  enum Type { NAME, NUMBER, SENSE, COLON, PLUS, MINUS, OTHER, END };
+  Type type;
+  std::string text;
+  double value;
+  // 'L', 'G' or 'E' for a SENSE.
+  char sense;
+  // Whether this is the first token on its line.
+  bool lineStart;
+};
+
+bool isNameChar(char c) {
+  return isalnum(static_cast<unsigned char>(c)) ||
+    ((c != '\0') && (strchr("!\"#$%&()/,.;?@_`'{}|~", c) != nullptr));
+}
+
+/**
+ * Splits LP format text into tokens, with one token of lookahead.
+ */
+class Lexer {
+  public:
+    explicit Lexer(LineSource & in) : in_(in), pos_(nullptr), end_(nullptr),
+        line_(0) {
+      read(next_);
+    }
+
+    /**
+     * Move on to the next token, and return it.
+     */
+    const Token & advance() {
+      std::swap(cur_, next_);
+      read(next_);
+      return cur_;
+    }
+
+    const Token & peek() const { return next_; }
+
+    /**
+     * The line that the next token is on.
+     */
+    size_t line() const { return line_; }
+
+  private:
+    void read(Token & t) {
+      t.lineStart = false;
+      for(;;) {
+        while ((pos_ < end_) && isspace(static_cast<unsigned char>(*pos_))) {
+          ++pos_;
+        }
+        // A backslash starts a comment, which runs to the end of the line.
+        if ((pos_ < end_) && (*pos_ != '\\')) {
+          break;
+        }
+        if (! in_.getline(pos_, end_)) {
+          t.type = Token::END;
+          t.text.clear();
+          return;
+        }
+        line_++;
+        t.lineStart = true;
+      }
+      const char * start = pos_;
+      char c = *pos_++;
+      bool digitNext = (pos_ < end_) &&
+        isdigit(static_cast<unsigned char>(*pos_));
+      if (isdigit(static_cast<unsigned char>(c)) || ((c == '.') && digitNext)) {
+        while ((pos_ < end_) && (isdigit(static_cast<unsigned char>(*pos_)) ||
+              (*pos_ == '.'))) {
+          ++pos_;
+        }
+        if ((pos_ < end_) && ((*pos_ == 'e') || (*pos_ == 'E'))) {
+          const char * exp = pos_ + 1;
+          if ((exp < end_) && ((*exp == '+') || (*exp == '-'))) {
+            ++exp;
+          }
+          if ((exp < end_) && isdigit(static_cast<unsigned char>(*exp))) {
+            pos_ = exp;
+            while ((pos_ < end_) && isdigit(static_cast<unsigned char>(*pos_))) {
+              ++pos_;
+            }
+          }
+        }
+        t.type = Token::NUMBER;
+        t.text.assign(start, pos_);
+        t.value = strtod(t.text.c_str(), nullptr);
+        return;
+      }
+      if (isNameChar(c)) {
+        while ((pos_ < end_) && isNameChar(*pos_)) {
+          ++pos_;
+        }
+        t.type = Token::NAME;
+        t.text.assign(start, pos_);
+        return;
+      }
+      char following = (pos_ < end_) ? *pos_ : '\0';
+      t.type = Token::SENSE;
+      switch (c) {
+        case '<':
+          t.sense = 'L';
+          pos_ += (following == '=');
+          break;
+        case '>':
+          t.sense = 'G';
+          pos_ += (following == '=');
+          break;
+        case '=':
+          if ((following == '<') || (following == '>')) {
+            t.sense = (following == '<') ? 'L' : 'G';
+            ++pos_;
+          } else {
+            t.sense = 'E';
+            pos_ += (following == '=');
+          }
+          break;
+        case ':':
+          t.type = Token::COLON;
+          break;
+        case '+':
+          t.type = Token::PLUS;
+          break;
+        case '-':
+          // "->" belongs to an indicator constraint.
+          t.type = (following == '>') ? Token::OTHER : Token::MINUS;
+          break;
+        default:
+          // Quadratic terms, and anything else we don't know.
+          t.type = Token::OTHER;
+          break;
+      }
+      t.text.assign(start, pos_);
+    }
+
+    LineSource & in_;
+    const char * pos_;
+    const char * end_;
+    size_t line_;
+    Token cur_;
+    Token next_;
+};
+
+/**
+ * Builds a Model from the tokens of an LP file. Rows are collected row by
+ * row, and turned into CPLEX's column-wise form at the end.
+ */
+class LPParser {
+  public:
+    LPParser(LineSource & in, const char * filename) : lex_(in),
+        filename_(filename), objsen_(CPX_MIN) { }
+
+    LPStatus parse(Model & model);
+
+  private:
+    enum Section { NONE, OBJECTIVE, CONSTRAINTS, BOUNDS, GENERALS, BINARIES,
+      END, UNSUPPORTED };
+
+    /**
+     * The section started by t, which has just been read and for which
+     * isSection() is true. Reads the second word of two-word section
+     * names.
+     */
+    Section section(const Token & t);
+
+    bool isSection(const Token & t) const;
+    LPStatus objective();
+    LPStatus constraint();
+    LPStatus bound();
+    LPStatus integers(char ctype);
+
+    /**
+     * Read terms until something that isn't a term, adding them to the
+     * current row (or to the objective if toObjective is set) and adding
+     * constants to constant.
+     */
+    LPStatus expression(bool toObjective, double & constant);
+
+    /**
+     * Read a number, or +-inf, into value.
+     */
+    LPStatus number(double & value);
+
+    CPXDIM column(const std::string & name);
+    void addToRow(CPXDIM j, double val);
+    void endRow(char sense, double rhs, double rngval);
+    LPStatus error(const std::string & message);
+
+    Lexer lex_;
+    const char * filename_;
+    int objsen_;
+    std::unordered_map<std::string, CPXDIM> columns_;
+    std::vector<double> obj_;
+    std::vector<double> lb_;
+    std::vector<double> ub_;
+    std::vector<char> ctype_;
+    // Where each column is in the current row, if it is.
+    std::vector<CPXNNZ> where_;
+    std::vector<CPXNNZ> rowBeg_;
+    std::vector<CPXDIM> rowInd_;
+    std::vector<double> rowVal_;
+    std::vector<double> rhs_;
+    std::vector<char> sense_;
+    std::vector<double> rngval_;
+};
+
+LPStatus LPParser::error(const std::string & message) {
+  std::cerr << "Error: " << filename_ << ":" << lex_.line() << ": " << message
+    << std::endl;
+  return LP_FAILED;
+}
+
+bool LPParser::isSection(const Token & t) const {
+  if (! t.lineStart || (t.type != Token::NAME)) {
+    return false;
+  }
+  static const char * keywords[] = { "maximize", "maximise", "maximum", "max",
+    "minimize", "minimise", "minimum", "min", "subject", "such", "st", "s.t.",
+    "bounds", "bound", "general", "generals", "gen", "integer", "integers",
+    "binary", "binaries", "bin", "semi", "semis", "sos", "lazy", "user",
+    "end" };
+  for(auto keyword: keywords) {
+    if (iequals(t.text, keyword)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+LPParser::Section LPParser::section(const Token & t) {
+  const std::string & w = t.text;
+  if (iequals(w, "maximize") || iequals(w, "maximise") ||
+      iequals(w, "maximum") || iequals(w, "max")) {
+    objsen_ = CPX_MAX;
+    return OBJECTIVE;
+  }
+  if (iequals(w, "minimize") || iequals(w, "minimise") ||
+      iequals(w, "minimum") || iequals(w, "min")) {
+    objsen_ = CPX_MIN;
+    return OBJECTIVE;
+  }
+  if (iequals(w, "subject") || iequals(w, "such")) {
+    const Token & second = lex_.peek();
+    if ((second.type == Token::NAME) &&
+        (iequals(second.text, "to") || iequals(second.text, "that"))) {
+      lex_.advance();
+    }
+    return CONSTRAINTS;
+  }
+  if (iequals(w, "st") || iequals(w, "s.t.")) {
+    return CONSTRAINTS;
+  }
+  if (iequals(w, "bounds") || iequals(w, "bound")) {
+    return BOUNDS;
+  }
+  if (iequals(w, "binary") || iequals(w, "binaries") || iequals(w, "bin")) {
+    return BINARIES;
+  }
+  if (iequals(w, "end")) {
+    return END;
+  }
+  if (iequals(w, "general") || iequals(w, "generals") || iequals(w, "gen") ||
+      iequals(w, "integer") || iequals(w, "integers")) {
+    return GENERALS;
+  }
+  // Semi-continuous variables, SOS, lazy constraints and user cuts.
+  return UNSUPPORTED;
+}
+
+CPXDIM LPParser::column(const std::string & name) {
+  auto found = columns_.find(name);
+  if (found != columns_.end()) {
+    return found->second;
+  }
+  CPXDIM j = static_cast<CPXDIM>(obj_.size());
+  columns_.emplace(name, j);
+  obj_.push_back(0);
+  lb_.push_back(0);
+  ub_.push_back(INF);
+  ctype_.push_back(CPX_CONTINUOUS);
+  where_.push_back(-1);
+  return j;
+}
+
+void LPParser::addToRow(CPXDIM j, double val) {
+  if (where_[j] >= 0) {
+    rowVal_[where_[j]] += val;
+    return;
+  }
+  where_[j] = rowInd_.size();
+  rowInd_.push_back(j);
+  rowVal_.push_back(val);
+}
+
+void LPParser::endRow(char sense, double rhs, double rngval) {
+  for(CPXNNZ k = rowBeg_.back(); k < static_cast<CPXNNZ>(rowInd_.size());
+      ++k) {
+    where_[rowInd_[k]] = -1;
+  }
+  sense_.push_back(sense);
+  rhs_.push_back(rhs);
+  rngval_.push_back(rngval);
+  rowBeg_.push_back(rowInd_.size());
+}
+
+LPStatus LPParser::number(double & value) {
+  double sign = 1;
+  const Token * t = &lex_.peek();
+  while ((t->type == Token::PLUS) || (t->type == Token::MINUS)) {
+    if (t->type == Token::MINUS) {
+      sign = -sign;
+    }
+    lex_.advance();
+    t = &lex_.peek();
+  }
+  if (t->type == Token::NUMBER) {
+    value = sign * t->value;
+  } else if ((t->type == Token::NAME) &&
+      (iequals(t->text, "inf") || iequals(t->text, "infinity"))) {
+    value = sign * INF;
+  } else {
+    return error("Expected a number, not \"" + t->text + "\".");
+  }
+  lex_.advance();
+  return LP_READ;
+}
+
+LPStatus LPParser::expression(bool toObjective, double & constant) {
+  for(;;) {
+    const Token * t = &lex_.peek();
+    if (isSection(*t)) {
+      return LP_READ;
+    }
+    double sign = 1;
+    bool signed_ = false;
+    while ((t->type == Token::PLUS) || (t->type == Token::MINUS)) {
+      if (t->type == Token::MINUS) {
+        sign = -sign;
+      }
+      signed_ = true;
+      lex_.advance();
+      t = &lex_.peek();
+    }
+    double coef = 1;
+    bool haveNumber = false;
+    if (t->type == Token::NUMBER) {
+      coef = t->value;
+      haveNumber = true;
+      lex_.advance();
+      t = &lex_.peek();
+    }
+    if ((t->type == Token::NAME) && ! isSection(*t)) {
+      CPXDIM j = column(t->text);
+      lex_.advance();
+      if (toObjective) {
+        obj_[j] += sign * coef;
+      } else {
+        addToRow(j, sign * coef);
+      }
+    } else if (haveNumber) {
+      constant += sign * coef;
+    } else if (t->type == Token::OTHER) {
+      return LP_UNSUPPORTED;
+    } else if (signed_) {
+      return error("Expected a term, not \"" + t->text + "\".");
+    } else {
+      return LP_READ;
+    }
+  }
+}
+
+LPStatus LPParser::objective() {
+  // The objective's name is a NAME followed by a COLON, which expression()
+  // would take as a variable, so look for it first.
+  if ((lex_.peek().type == Token::NAME) && ! isSection(lex_.peek())) {
+    std::string name = lex_.peek().text;
+    lex_.advance();
+    if (lex_.peek().type == Token::COLON) {
+      lex_.advance();
+    } else {
+      obj_[column(name)] += 1;
+    }
+  }
+  // Any constant is an offset, which doesn't change which points are best.
+  double constant = 0;
+  return expression(true, constant);
+}
+
+LPStatus LPParser::constraint() {
+  // A row may start with its name, which expression() would take as a
+  // variable.
+  if (lex_.peek().type == Token::NAME) {
+    std::string name = lex_.peek().text;
+    lex_.advance();
+    if (lex_.peek().type == Token::COLON) {
+      lex_.advance();
+    } else {
+      addToRow(column(name), 1);
+    }
+  }
+  double constant = 0;
+  LPStatus status = expression(false, constant);
+  if (status != LP_READ) {
+    return status;
+  }
+  if (lex_.peek().type != Token::SENSE) {
+    if (lex_.peek().type == Token::OTHER) {
+      return LP_UNSUPPORTED;
+    }
+    return error("Expected <=, >= or =, not \"" + lex_.peek().text + "\".");
+  }
+  char sense = lex_.advance().sense;
+  bool ranged = (rowBeg_.back() == static_cast<CPXNNZ>(rowInd_.size()));
+  if (! ranged) {
+    double rhs;
+    status = number(rhs);
+    if (status != LP_READ) {
+      return status;
+    }
+    if (lex_.peek().type == Token::OTHER) {
+      // An indicator constraint.
+      return LP_UNSUPPORTED;
+    }
+    endRow(sense, rhs - constant, 0);
+    return LP_READ;
+  }
+  // A ranged row, written as lo <= expression <= hi. So far we only have lo.
+  double first = constant;
+  constant = 0;
+  status = expression(false, constant);
+  if (status != LP_READ) {
+    return status;
+  }
+  if (lex_.peek().type != Token::SENSE) {
+    return error("Expected <=, >= or =, not \"" + lex_.peek().text + "\".");
+  }
+  char secondSense = lex_.advance().sense;
+  double second;
+  status = number(second);
+  if (status != LP_READ) {
+    return status;
+  }
+  if ((sense != secondSense) || (sense == 'E')) {
+    return error("A ranged row needs two <= or two >=.");
+  }
+  double lo = (sense == 'L') ? first : second;
+  double hi = (sense == 'L') ? second : first;
+  endRow('R', lo - constant, hi - lo);
+  return LP_READ;
+}
+
+LPStatus LPParser::bound() {
+  const Token & t = lex_.peek();
+  bool nameFirst = (t.type == Token::NAME) && ! iequals(t.text, "inf") &&
+    ! iequals(t.text, "infinity");
+  double first = 0;
+  char firstSense = 'E';
+  if (! nameFirst) {
+    // value <= x, value >= x or value = x.
+    LPStatus status = number(first);
+    if (status != LP_READ) {
+      return status;
+    }
+    if (lex_.peek().type != Token::SENSE) {
+      return error("Expected <=, >= or =, not \"" + lex_.peek().text + "\".");
+    }
+    firstSense = lex_.advance().sense;
+  }
+  if (lex_.peek().type != Token::NAME) {
+    return error("Expected a variable, not \"" + lex_.peek().text + "\".");
+  }
+  std::string name = lex_.advance().text;
+  CPXDIM j = column(name);
+  if (! nameFirst) {
+    if (firstSense != 'G') {
+      lb_[j] = first;
+    }
+    if (firstSense != 'L') {
+      ub_[j] = first;
+    }
+  }
+  const Token & next = lex_.peek();
+  if ((next.type == Token::NAME) && ! next.lineStart &&
+      iequals(next.text, "free")) {
+    lex_.advance();
+    lb_[j] = -INF;
+    ub_[j] = INF;
+    return LP_READ;
+  }
+  if ((next.type != Token::SENSE) || next.lineStart) {
+    if (nameFirst) {
+      return error("Expected a bound on " + name + ".");
+    }
+    return LP_READ;
+  }
+  char sense = lex_.advance().sense;
+  double value;
+  LPStatus status = number(value);
+  if (status != LP_READ) {
+    return status;
+  }
+  if (sense != 'L') {
+    lb_[j] = value;
+  }
+  if (sense != 'G') {
+    ub_[j] = value;
+  }
+  return LP_READ;
+}
+
+LPStatus LPParser::integers(char ctype) {
+  while ((lex_.peek().type == Token::NAME) && ! isSection(lex_.peek())) {
+    CPXDIM j = column(lex_.advance().text);
+    ctype_[j] = ctype;
+    if (ctype == CPX_BINARY) {
+      lb_[j] = 0;
+      ub_[j] = 1;
+    }
+  }
+  return LP_READ;
+}
+
+LPStatus LPParser::parse(Model & model) {
+  rowBeg_.push_back(0);
+  Section current = NONE;
+  while (lex_.peek().type != Token::END) {
+    if (isSection(lex_.peek())) {
+      current = section(lex_.advance());
+      if (current == END) {
+        break;
+      }
+      if (current == UNSUPPORTED) {
+        return LP_UNSUPPORTED;
+      }
+      if (current == OBJECTIVE) {
+        LPStatus status = objective();
+        if (status != LP_READ) {
+          return status;
+        }
+      }
+      continue;
+    }
+    LPStatus status;
+    switch (current) {
+      case CONSTRAINTS:
+        status = constraint();
+        break;
+      case BOUNDS:
+        status = bound();
+        break;
+      case GENERALS:
+        status = integers(CPX_INTEGER);
+        break;
+      case BINARIES:
+        status = integers(CPX_BINARY);
+        break;
+      case NONE:
+        return error("Expected the objective sense, not \"" +
+            lex_.peek().text + "\".");
+      default:
+        status = error("Unexpected \"" + lex_.peek().text + "\".");
+        break;
+    }
+    if (status != LP_READ) {
+      return status;
+    }
+    if ((lex_.peek().type == Token::OTHER) && (current != CONSTRAINTS)) {
+      return LP_UNSUPPORTED;
+    }
+    if (((current == GENERALS) || (current == BINARIES)) &&
+        ! isSection(lex_.peek()) && (lex_.peek().type != Token::END)) {
+      return error("Expected a variable, not \"" + lex_.peek().text + "\".");
+    }
+  }
+
+  // Turn the rows into columns, leaving out explicit zeros.
+  Model m;
+  m.numcols = static_cast<CPXDIM>(obj_.size());
+  m.numrows = static_cast<CPXDIM>(rhs_.size());
+  m.objsen = objsen_;
+  m.obj.swap(obj_);
+  m.rhs.swap(rhs_);
+  m.sense.swap(sense_);
+  m.rngval.swap(rngval_);
+  m.matbeg.assign(m.numcols, 0);
+  m.matcnt.assign(m.numcols, 0);
+  for(size_t k = 0; k < rowInd_.size(); ++k) {
+    m.matcnt[rowInd_[k]] += (rowVal_[k] != 0);
+  }
+  CPXNNZ nz = 0;
+  for(CPXDIM j = 0; j < m.numcols; ++j) {
+    m.matbeg[j] = nz;
+    nz += m.matcnt[j];
+  }
+  m.matind.resize(nz);
+  m.matval.resize(nz);
+  std::vector<CPXNNZ> fill(m.matbeg);
+  for(CPXDIM i = 0; i < m.numrows; ++i) {
+    for(CPXNNZ k = rowBeg_[i]; k < rowBeg_[i+1]; ++k) {
+      if (rowVal_[k] == 0) {
+        continue;
+      }
+      CPXNNZ to = fill[rowInd_[k]]++;
+      m.matind[to] = i;
+      m.matval[to] = rowVal_[k];
+    }
+  }
+  // CPLEX treats anything beyond CPX_INFBOUND as infinite.
+  m.lb.resize(m.numcols);
+  m.ub.resize(m.numcols);
+  for(CPXDIM j = 0; j < m.numcols; ++j) {
+    m.lb[j] = std::max(lb_[j], -CPX_INFBOUND);
+    m.ub[j] = std::min(ub_[j], CPX_INFBOUND);
+  }
+  for(size_t i = 0; i < m.rhs.size(); ++i) {
+    m.rhs[i] = std::max(-CPX_INFBOUND, std::min(m.rhs[i], CPX_INFBOUND));
+  }
+  bool integer = false;
+  for(char c: ctype_) {
+    integer |= (c != CPX_CONTINUOUS);
+  }
+  if (integer) {
+    m.ctype.swap(ctype_);
+  }
+  model = std::move(m);
+  return LP_READ;
+}
+}
+
+bool isLPFile(const char * filename) {
+  return endsWith(filename, ".lp") || endsWith(filename, ".lp.gz") ||
+    endsWith(filename, ".lp.zst");
+}
+
+LPStatus readLP(const char * filename, Model & model) {
+  LineSource * in;
+  if (endsWith(filename, ".gz")) {
+#ifdef HAVE_ZLIB
+    in = new GzipFile(filename);
+#else
+    // CPLEX can read gzipped files itself.
+    return LP_UNSUPPORTED;
+#endif
+  } else if (endsWith(filename, ".zst")) {
+#ifdef HAVE_ZSTD
+    in = new ZstdFile(filename);
+#else
+    std::cerr << "Error: boxsplit was built without zstd, so can't read "
+      << filename << std::endl;
+    return LP_FAILED;
+#endif
+  } else {
+    in = new MappedFile(filename);
+  }
+  LPStatus status = LP_FAILED;
+  if (in->good()) {
+    LPParser parser(*in, filename);
+    status = parser.parse(model);
+    if (! in->good()) {
+      status = LP_FAILED;
+    }
+  }
+  delete in;
+  return status;
+}
@@ -0,0 +1,44 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+
+#ifndef LPREADER_HPP
+#define LPREADER_HPP
+
+#include "model.hpp"
+
+/**
+ * What readLP did:
+ * LP_READ - the problem is now in the Model
+ * LP_UNSUPPORTED - the file uses something readLP doesn't handle, such as
+ *                  quadratic terms, SOS or indicator constraints, so CPLEX
+ *                  should read it instead
+ * LP_FAILED - the file couldn't be read, and the reason has been printed
+ */
+enum LPStatus { LP_READ, LP_UNSUPPORTED, LP_FAILED };
+
+/**
+ * Whether filename is an LP file: it ends in .lp, .lp.gz or .lp.zst.
+ */
+bool isLPFile(const char * filename);
+
+/**
+ * Read a problem in CPLEX's LP format straight into model, without going
+ * through CPLEX. Plain files are memory mapped, and .gz and .zst files are
+ * decompressed as they are read (if boxsplit was built with zlib and zstd).
+ * Variables are numbered in the order they first appear, as CPLEX does.
+ * model is only changed if this returns LP_READ.
+ */
+LPStatus readLP(const char * filename, Model & model);
+
+#endif /* LPREADER_HPP */
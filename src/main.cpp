@@ -12,10 +12,12 @@ You should have received a copy of the GNU General Public License along with thi
 */
 
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
 #include <queue>
+#include <thread>
 #include <vector>
 
 #include <ilcplex/cplexx.h>
@@ -23,10 +25,17 @@ You should have received a copy of the GNU General Public License along with thi
 #include <boost/program_options.hpp>
 
 #include "box.hpp"
+#include "checkpoint.hpp"
 #include "boxfinder.hpp"
 #include "jobserver.hpp"
 #include "problem.hpp"
+#include "recording.hpp"
+#include "remote.hpp"
 #include "result.hpp"
+#include "scheduler.hpp"
+#include "solver.hpp"
+#include "streamwriter.hpp"
+#include "trace.hpp"
 #include "env.hpp"
 
 
@@ -42,18 +51,281 @@ std::mutex debug_mutex;
 
 std::atomic<int> ipcount;
 
+/**
+ * Everything the user chose on the command line that run() needs.
+ */
+struct Settings {
+  int num_threads;
+  // 0 if each solve uses one thread. See JobServer::shareCores().
+  int cores;
+  bool deterministic;
+  bool warm_start;
+  bool harvest_pool;
+  bool extremes;
+  Policy schedule;
+  Backend backend;
+  std::string outputFilename;
+  // Empty if not wanted.
+  std::string checkpointFilename;
+  double checkpointInterval;
+  std::string resumeFilename;
+  // Empty if not wanted. See remote.hpp.
+  std::string listenAddress;
+  std::string connectAddress;
+  // Empty if not wanted. See recording.hpp.
+  std::string recordFilename;
+  std::string replayFilename;
+  double replayLatency;
+  clock_t starttime;
+  double startelapsed;
+};
+
+/**
+ * The box that holds every point, for a problem with the given sense and
+ * utopia point.
+ */
+template<int N>
+static Box<N> * firstBox(Sense sense, const CPXLONG utopia[]) {
+  CPXLONG u[N];
+  CPXLONG v[N];
+  if (sense == MIN) {
+    for (int i = 0; i < N; ++i) {
+      u[i] = INT_MAX;
+      v[i] = utopia[i]-1;
+    }
+  } else {
+    for (int i = 0; i < N; ++i) {
+      u[i] = 0;
+      v[i] = utopia[i]+1;
+    }
+  }
+  return new Box<N>(u, v);
+}
+
+/**
+ * Find an extreme point of the nondominated set for each objective: the
+ * point that minimises the scalarisation among those with the best value of
+ * that objective. These are found at the same time on the first N solvers
+ * (taking turns if there are fewer), which have their utopia point set here,
+ * with the threads split between them. If there are no solvers, one is
+ * opened just for this. Each point is returned in the box it was found in;
+ * the vector holds nullptr for any objective whose box holds no point.
+ */
+template<int N>
+static std::vector<Result<N> *> extremePoints(const Settings & settings,
+    const Problem & p, const CPXLONG utopia[],
+    const std::vector<Solver *> & solvers) {
+  std::vector<Solver *> finders(solvers.begin(),
+      solvers.begin() + std::min(solvers.size(), static_cast<size_t>(N)));
+  Solver * own = nullptr;
+  if (finders.empty()) {
+    own = Solver::create(settings.backend, p);
+    finders.push_back(own);
+  }
+  size_t cores = std::max(solvers.size(), static_cast<size_t>(1));
+  std::vector<Result<N> *> points(N, nullptr);
+  std::vector<std::thread> threads;
+  for(size_t t = 0; t < finders.size(); ++t) {
+    threads.emplace_back([&, t] {
+        Solver * solver = finders[t];
+        solver->setUtopia(utopia);
+        solver->setThreads(cores / finders.size() +
+            ((t < cores % finders.size()) ? 1 : 0));
+        for(size_t i = t; i < N; i += finders.size()) {
+          // Only points with the best value of objective i lie in this box.
+          Box<N> * box = firstBox<N>(p.objsen, utopia);
+          box->u[i] = (p.objsen == MIN) ? utopia[i] + 1 : utopia[i] - 1;
+          BoxFinder<N> finder(p.filename(), p.objsen, nullptr, *solver, box,
+              std::vector<Result<N> *>(), settings.warm_start,
+              settings.harvest_pool);
+          Result<N> * res = finder();
+          if (res->isEmpty()) {
+            delete box;
+            delete res;
+          } else {
+            points[i] = res;
+          }
+        }
+        solver->setThreads(1);
+      });
+  }
+  for(auto & thread: threads) {
+    thread.join();
+  }
+  delete own;
+  return points;
+}
+
+/**
+ * Write the points found by server, and statistics about the run, to
+ * outputFilename.
+ */
+template<int N>
+static int writeResults(const Settings & settings, JobServer<N> & server) {
+  // Already sorted biggest to smallest, with no duplicates.
+  std::list<Result<N> *> solutions = server.getSolutions();
+
+  /* Stop the clock. Print results.*/
+  clock_t endtime = clock();
+  double cpu_time_used=(static_cast<double>(endtime - settings.starttime)) / CLOCKS_PER_SEC;
+  timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double elapsedtime = (end.tv_sec + end.tv_nsec/1e9 - settings.startelapsed);
+  constexpr int width = 8;
+  constexpr int precision = 3;
+  std::ofstream outFile;
+  outFile.open(settings.outputFilename);
+  outFile << std::endl << "Using BoxFinder at " << HASH << std::endl;
+  for(auto r: solutions) {
+    outFile << r->soln[0];
+    for(int i = 1; i < N; ++i) {
+      outFile << "\t" << r->soln[i];
+    }
+    outFile << std::endl;
+  }
+  outFile << std::endl << "---" << std::endl;
+  int solCount = solutions.size();
+  outFile << cpu_time_used << " CPU seconds" << std::endl;
+  outFile << std::setw(width) << std::setprecision(precision) << std::fixed;
+  outFile << elapsedtime << " elapsed seconds" << std::endl;
+  outFile << std::setw(width) << std::setprecision(precision) << std::fixed;
+  outFile << ipcount << " IPs solved" << std::endl;
+  outFile << std::setw(width) << std::setprecision(precision) << std::fixed;
+  outFile << solCount << " Solutions found" << std::endl;
+  outFile << std::setw(width) << std::setprecision(precision) << std::fixed;
+  outFile << server.cancelledCount() << " IPs interrupted while being solved"
+    << std::endl;
+  outFile << std::setw(width) << std::setprecision(precision) << std::fixed;
+  outFile << server.cancelledSeconds() << " seconds spent in interrupted IPs"
+    << std::endl;
+  outFile << std::setw(width) << std::setprecision(precision) << std::fixed;
+  outFile << server.savedSeconds() << " seconds saved by cancelling (estimated)"
+    << std::endl;
+  return 0;
+}
+
+/**
+ * Run the JobServer on answers from a recording with N objectives, rather
+ * than a problem, and write the points found to outputFilename.
+ */
+template<int N>
+static int replay(const Settings & settings, StreamWriter * stream,
+    Trace * trace) {
+  Replay<N> recording;
+  if (! recording.read(settings.replayFilename)) {
+    return 1;
+  }
+  JobServer<N> server(settings.num_threads, &recording,
+      settings.replayLatency, settings.schedule, stream, trace);
+  server.q(firstBox<N>(recording.sense, recording.utopia));
+  server.wait();
+  return writeResults<N>(settings, server);
+}
+
+/**
+ * Find the nondominated points of p, which has N objectives, and write them
+ * to outputFilename.
+ */
+template<int N>
+static int run(const Problem & p, const Settings & settings,
+    StreamWriter * stream, Trace * trace) {
+  if (! settings.connectAddress.empty()) {
+    // Solve boxes for a coordinator elsewhere, which has the utopia point.
+    return remoteWorkers<N>(settings.connectAddress, p, settings.num_threads,
+        settings.harvest_pool, settings.backend);
+  }
+  CPXLONG utopia[N];
+  Checkpoint<N> resume;
+  bool resumed = ! settings.resumeFilename.empty();
+  if (resumed) {
+    if (! resume.read(settings.resumeFilename)) {
+      return 1;
+    }
+    if (resume.sense != p.objsen) {
+      std::cerr << "Error: Checkpoint " << settings.resumeFilename
+        << " was written for a different problem." << std::endl;
+      return 1;
+    }
+    // The checkpoint has the utopia point, so we don't need to find it.
+    for(int i = 0; i < N; ++i) {
+      utopia[i] = resume.utopia[i];
+    }
+    ipcount = resume.ipcount;
+  }
+  // Open the workers' solvers now. Unless resuming, some of them optimise in
+  // each direction to find the utopia point while the rest are opened.
+  std::vector<Solver *> solvers;
+  if (! Solver::open(settings.backend, p, settings.num_threads,
+        resumed ? nullptr : utopia, solvers)) {
+    std::cerr << "Error: Could not find the utopia point." << std::endl;
+    return 1;
+  }
+  std::vector<Result<N> *> extremes;
+  if (! resumed) {
+    ipcount += N;
+    if (settings.extremes) {
+      extremes = extremePoints<N>(settings, p, utopia, solvers);
+    }
+  }
+
+  JobServer<N> server(settings.num_threads, utopia, p, std::move(solvers),
+      settings.warm_start, settings.harvest_pool, settings.backend,
+      settings.schedule, stream, trace);
+  if (settings.cores > 0) {
+    server.shareCores(settings.cores, settings.deterministic);
+  }
+  if (! settings.checkpointFilename.empty()) {
+    server.checkpointTo(settings.checkpointFilename,
+        settings.checkpointInterval);
+  }
+  if (! settings.listenAddress.empty()) {
+    if (! server.listen(settings.listenAddress)) {
+      std::cerr << "Error: Could not listen on " << settings.listenAddress
+        << std::endl;
+      return 1;
+    }
+  }
+  if (! settings.recordFilename.empty()) {
+    if (! server.recordTo(settings.recordFilename)) {
+      std::cerr << "Error: Could not open " << settings.recordFilename
+        << std::endl;
+      return 1;
+    }
+  }
+
+  if (settings.resumeFilename.empty()) {
+    // The extreme points split the first box as soon as it is queued, so
+    // that there are boxes for more than one worker from the start.
+    for(auto res: extremes) {
+      if (res) {
+        server.found(res);
+      }
+    }
+    server.q(firstBox<N>(p.objsen, utopia));
+  } else {
+    // Carry on from the checkpoint. Boxes that were being solved when it was
+    // written are solved again.
+    for(auto & point: resume.points) {
+      server.seed(new Result<N>(nullptr, point.soln));
+    }
+    for(auto & record: resume.boxes) {
+      auto * box = new Box<N>(record.u, record.v);
+      box->depth = record.depth;
+      server.q(box);
+    }
+  }
+  server.wait();
+  return writeResults<N>(settings, server);
+}
+
 int main(int argc, char* argv[]) {
 
   int status = 0; /* Operation status */
   ipcount = 0;
   Env e;
 
-  std::string pFilename, outputFilename;
-
-  /* Timing */
-  clock_t starttime, endtime;
-  double cpu_time_used, elapsedtime, startelapsed;
-  int num_threads;
+  std::string pFilename, streamFilename, traceFilename;
+  Settings settings;
 
   po::variables_map va_map;
   po::options_description opt("Options for boxfinder");
@@ -61,13 +333,96 @@ int main(int argc, char* argv[]) {
     ("help,h", "Show this help.")
     ("lp,p",
       po::value<std::string>(&pFilename),
-     "The LP file to solve. Required.")
+     "The LP file (optionally .lp.gz or .lp.zst) or MOP file to solve. "
+     "Required.")
     ("output,o",
-      po::value<std::string>(&outputFilename),
+      po::value<std::string>(&settings.outputFilename),
      "The output file. Required.")
     ("threads,t",
-      po::value<int>(&num_threads)->default_value(1),
-     "Number of threads to use internally. Optional, default to 1.")
+      po::value<int>(&settings.num_threads)->default_value(1),
+     "Number of threads to use internally. With --listen this may be 0, so "
+     "that all boxes are solved by worker processes. With --connect, the "
+     "number of boxes to solve at once. Optional, default to 1.")
+    ("cores",
+      po::value<int>(&settings.cores)->default_value(0),
+     "Share this many cores between the solves. While there are fewer "
+     "boxes than threads, each solve uses several threads, and new solves "
+     "use fewer again as more boxes appear. Optional, default to 0 (every "
+     "solve uses one thread).")
+    ("deterministic",
+      po::bool_switch(&settings.deterministic),
+     "With --cores, give every solve the same share of the cores, and keep "
+     "CPLEX in deterministic parallel mode, so that each box's answer does "
+     "not depend on timing. Optional.")
+    ("warm-start",
+      po::bool_switch(&settings.warm_start),
+     "Keep the solution of each point found, and offer the known points on "
+     "the edge of each box to CPLEX as MIP starts for it to repair into the "
+     "box. Optional.")
+    ("pool",
+      po::bool_switch(&settings.harvest_pool),
+     "After each solve, look for further nondominated points in the CPLEX "
+     "solution pool. Optional.")
+    ("extremes",
+      po::bool_switch(&settings.extremes),
+     "Before splitting the first box, find an extreme point for each "
+     "objective (the best value of that objective, then the best "
+     "scalarisation) in parallel, so that the run starts with boxes for "
+     "several workers. Ignored with --resume. Optional.")
+    ("schedule",
+      po::value<Policy>(&settings.schedule)->default_value(FIFO),
+     "The order in which boxes are solved: fifo, volume (largest first), "
+     "depth (most split first) or yield (the depth that has found most new "
+     "points so far). Optional, default to fifo.")
+    ("solver",
+      po::value<Backend>(&settings.backend)->default_value(CPLEX),
+     "How boxes are solved: cplex, or enumerate (a built-in branch and bound "
+     "for small pure integer problems with bounded variables, which avoids "
+     "starting CPLEX in every worker). Optional, default to cplex.")
+    ("stream",
+      po::value<std::string>(&streamFilename),
+     "Also write each new point to this file as soon as it is found, with "
+     "the elapsed seconds and the number of IPs solved so far. The output "
+     "file is still written at the end. Optional.")
+    ("trace",
+      po::value<std::string>(&traceFilename),
+     "Record how long each thread spends waiting for boxes, building models, "
+     "solving and splitting, and write it to this file in Chrome trace-event "
+     "format when the run ends. Open it with Perfetto. Optional.")
+    ("checkpoint",
+      po::value<std::string>(&settings.checkpointFilename),
+     "Periodically save the state of the run to this file, so that it can "
+     "be resumed with --resume. Optional.")
+    ("checkpoint-interval",
+      po::value<double>(&settings.checkpointInterval)->default_value(600),
+     "Seconds between checkpoints. Optional, default to 600.")
+    ("resume",
+      po::value<std::string>(&settings.resumeFilename),
+     "Carry on from a checkpoint written by --checkpoint for the same "
+     "problem. Optional.")
+    ("record",
+      po::value<std::string>(&settings.recordFilename),
+     "Write the answer to every box solved, and how long it took, to this "
+     "file, so that the run can be replayed with --replay. Optional.")
+    ("replay",
+      po::value<std::string>(&settings.replayFilename),
+     "Instead of solving a problem, answer boxes from a file written by "
+     "--record. This needs no problem file and no CPLEX licence, and "
+     "measures the cost of scheduling and splitting boxes. Optional.")
+    ("replay-latency",
+      po::value<double>(&settings.replayLatency)->default_value(0),
+     "With --replay, wait for this multiple of each recorded solve time "
+     "before answering, e.g. 1 to mimic the recorded run. Optional, "
+     "default to 0 (answer at once).")
+    ("listen",
+      po::value<std::string>(&settings.listenAddress),
+     "Also hand boxes to worker processes started with --connect, which "
+     "connect to this address, either [host:]port or unix:path. Optional.")
+    ("connect",
+      po::value<std::string>(&settings.connectAddress),
+     "Run as a worker process for the coordinator listening on this "
+     "address, instead of solving the problem alone. The worker needs the "
+     "same problem file, but no output file. Optional.")
   ;
 
   po::store(po::parse_command_line(argc, argv, opt), va_map);
@@ -80,122 +435,107 @@ int main(int argc, char* argv[]) {
     return(1);
   }
 
-  if (va_map.count("lp") == 0) {
+  if ((va_map.count("lp") == 0) && (va_map.count("replay") == 0)) {
     std::cerr << "Error: You must pass in a problem file." << std::endl;
     std::cerr << opt << std::endl;
     return(1);
   }
 
-  std::ofstream outFile;
-
-  if (va_map.count("output") == 0) {
+  if ((va_map.count("output") == 0) && (va_map.count("connect") == 0)) {
     std::cerr << "Error: You must pass in an output file." << std::endl;
     std::cerr << opt << std::endl;
     return(1);
   }
 
+  if ((settings.num_threads < 1) &&
+      ((settings.num_threads < 0) || (va_map.count("listen") == 0))) {
+    std::cerr << "Error: You must use at least one thread, unless using "
+      "--listen." << std::endl;
+    return(1);
+  }
+
+  if (settings.cores < 0) {
+    std::cerr << "Error: --cores can't be negative." << std::endl;
+    return(1);
+  }
+
+  if (va_map.count("listen") && va_map.count("connect")) {
+    std::cerr << "Error: --listen and --connect can't be used together."
+      << std::endl;
+    return(1);
+  }
+
 
   /* Start the timer */
-  starttime = clock();
+  settings.starttime = clock();
   timespec start;
   clock_gettime(CLOCK_MONOTONIC, &start);
-  startelapsed = start.tv_sec + start.tv_nsec/1e9;
-
-  // Find global utopia/ideal point
-  // Need to read problem, which means setting up env.
-  e.env = CPXXopenCPLEX(&status);
-  Problem p(pFilename.c_str(), e);
-  if (p.objcnt != 3) {
-    std::cerr << "Error: This program only works on problems with 3 objective "
-      "functions." << std::endl;
-    exit(-1);
-  }
-  CPXsetintparam(e.env, CPXPARAM_Parallel, CPX_PARALLEL_DETERMINISTIC);
-  CPXsetintparam(e.env, CPXPARAM_Threads, 1);
-  CPXLONG utopia[p.objcnt];
-  for(int i = 0; i < p.objcnt; ++i) {
-    // Optimise in i direction
-    CPXDIM cur_numcols = CPXXgetnumcols(e.env, e.lp);
-    status = CPXXchgobj(e.env, e.lp, cur_numcols, p.objind[i], p.objcoef[i]);
-    if ( status ) {
-      std::cerr << "Failed to change objective function." << std::endl;
+  settings.startelapsed = start.tv_sec + start.tv_nsec/1e9;
+
+  StreamWriter * stream = nullptr;
+  if (va_map.count("stream")) {
+    stream = new StreamWriter(streamFilename, settings.startelapsed);
+    if (! stream->good()) {
+      std::cerr << "Error: Could not open " << streamFilename << std::endl;
+      return(1);
     }
-    status = CPXXmipopt (e.env, e.lp);
-    ipcount++;
-    if ( status ) {
-      std::cerr << "Failed to obtain objective value." << std::endl;
-    }
-    double val;
-    status = CPXXgetobjval(e.env, e.lp, &val);
-    utopia[i] = round(val);
   }
 
-  CPXLONG u[3];
-  CPXLONG v[3];
-  if (p.objsen == MIN) {
-    for (int i = 0; i < p.objcnt; ++i) {
-      u[i] = INT_MAX;
-      v[i] = utopia[i]-1;
-    }
-  } else {
-    for (int i = 0; i < p.objcnt; ++i) {
-      u[i] = 0;
-      v[i] = utopia[i]+1;
+  Trace * trace = nullptr;
+  if (va_map.count("trace")) {
+    trace = new Trace(traceFilename);
+    if (! trace->good()) {
+      std::cerr << "Error: Could not open " << traceFilename << std::endl;
+      return(1);
     }
   }
 
-
-  JobServer server(num_threads, utopia, p.objsen, pFilename);
-
-
-  // Create first Box
-  auto * firstBox = new Box(u, v);
-
-  server.q(firstBox);
-  server.wait();
-  std::list<Result *> solutions = server.getSolutions();
-
-  /* Stop the clock. Sort and print results.*/
-  endtime = clock();
-  cpu_time_used=(static_cast<double>(endtime - starttime)) / CLOCKS_PER_SEC;
-  clock_gettime(CLOCK_MONOTONIC, &start);
-  elapsedtime = (start.tv_sec + start.tv_nsec/1e9 - startelapsed);
-  // Sort biggest to smallest
-  solutions.sort([] (Result *a, Result *b) -> bool {
-      if (a->soln[0] == b->soln[0]) {
-        return a->soln[1] > b->soln[1];
-      }
-      return (a->soln[0] > b->soln[0]);
-      });
-  solutions.unique([] (Result *a, Result *b) -> bool {
-      for (int i = 0; i < 3; ++i) {
-        if (a->soln[i] != b->soln[i]) {
-          return false;
-        }
-      }
-      return true;
-      });
-  constexpr int width = 8;
-  constexpr int precision = 3;
-  outFile.open(outputFilename);
-  outFile << std::endl << "Using BoxFinder at " << HASH << std::endl;
-  for(auto r: solutions) {
-    outFile << r->soln[0];
-    for(int i = 1; i < 3; ++i) {
-      outFile << "\t" << r->soln[i];
+  if (va_map.count("replay")) {
+    switch (recordedObjectives(settings.replayFilename)) {
+      case 3:
+        status = replay<3>(settings, stream, trace);
+        break;
+      default:
+        std::cerr << "Error: This program only works on recordings with 3 "
+          "objective functions." << std::endl;
+        exit(-1);
     }
-    outFile << std::endl;
+    delete stream;
+    delete trace;
+    return status;
   }
-  outFile << std::endl << "---" << std::endl;
-  int solCount = solutions.size();
-  outFile << cpu_time_used << " CPU seconds" << std::endl;
-  outFile << std::setw(width) << std::setprecision(precision) << std::fixed;
-  outFile << elapsedtime << " elapsed seconds" << std::endl;
-  outFile << std::setw(width) << std::setprecision(precision) << std::fixed;
-  outFile << ipcount << " IPs solved" << std::endl;
-  outFile << std::setw(width) << std::setprecision(precision) << std::fixed;
-  outFile << solCount << " Solutions found" << std::endl;
+
+  // Find global utopia/ideal point
+  // Need to read problem. The enumerator works from the model in memory, so
+  // CPLEX is only opened here if it will solve the IPs, or if the problem
+  // file can only be read through CPLEX.
+  if (settings.backend == CPLEX) {
+    e.env = CPXXopenCPLEX(&status);
+  }
+  Problem p(pFilename.c_str(), e);
+  if (e.env != nullptr) {
+    CPXsetintparam(e.env, CPXPARAM_Parallel, CPX_PARALLEL_DETERMINISTIC);
+    CPXsetintparam(e.env, CPXPARAM_Threads, 1);
+  }
+  if (! Solver::canSolve(settings.backend, p)) {
+    return(1);
+  }
+  // Everything from here on works with a fixed number of objectives, so pick
+  // it once.
+  switch (p.objcnt) {
+    case 3:
+      status = run<3>(p, settings, stream, trace);
+      break;
+    default:
+      std::cerr << "Error: This program only works on problems with 3 objective "
+        "functions." << std::endl;
+      exit(-1);
+  }
+  delete stream;
+  delete trace;
   p.close(e);
-  CPXXcloseCPLEX(&e.env);
-  return 0;
+  if (e.env != nullptr) {
+    CPXXcloseCPLEX(&e.env);
+  }
+  return status;
 }
@@ -0,0 +1,95 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+#include <iostream>
+
+#include <ilcplex/cplexx.h>
+
+#include "errors.hpp"
+#include "model.hpp"
+
+int Model::read(CPXCENVptr env, CPXCLPptr lp) {
+  int status;
+  numcols = CPXXgetnumcols(env, lp);
+  numrows = CPXXgetnumrows(env, lp);
+  objsen = CPXXgetobjsen(env, lp);
+  CPXNNZ numnz = CPXXgetnumnz(env, lp);
+
+  obj.resize(numcols);
+  lb.resize(numcols);
+  ub.resize(numcols);
+  rhs.resize(numrows);
+  sense.resize(numrows);
+  rngval.resize(numrows);
+  matbeg.resize(numcols);
+  matcnt.resize(numcols);
+  matind.resize(numnz);
+  matval.resize(numnz);
+
+  status = CPXXgetobj(env, lp, obj.data(), 0, numcols-1);
+  status = status || CPXXgetlb(env, lp, lb.data(), 0, numcols-1);
+  status = status || CPXXgetub(env, lp, ub.data(), 0, numcols-1);
+  if (status) {
+    std::cerr << "Failed to copy columns." << std::endl;
+    return -ERR_CPLEX;
+  }
+  status = CPXXgetrhs(env, lp, rhs.data(), 0, numrows-1);
+  status = status || CPXXgetsense(env, lp, sense.data(), 0, numrows-1);
+  status = status || CPXXgetrngval(env, lp, rngval.data(), 0, numrows-1);
+  if (status) {
+    std::cerr << "Failed to copy rows." << std::endl;
+    return -ERR_CPLEX;
+  }
+
+  CPXNNZ nzcnt, surplus;
+  status = CPXXgetcols(env, lp, &nzcnt, matbeg.data(), matind.data(),
+                       matval.data(), numnz, &surplus, 0, numcols-1);
+  if (status) {
+    std::cerr << "Failed to copy constraint matrix." << std::endl;
+    return -ERR_CPLEX;
+  }
+  for(CPXDIM j = 0; j < numcols; ++j) {
+    CPXNNZ end = (j == numcols-1) ? nzcnt : matbeg[j+1];
+    matcnt[j] = static_cast<CPXDIM>(end - matbeg[j]);
+  }
+
+  ctype.clear();
+  if (CPXXgetprobtype(env, lp) != CPXPROB_LP) {
+    ctype.resize(numcols);
+    status = CPXXgetctype(env, lp, ctype.data(), 0, numcols-1);
+    if (status) {
+      std::cerr << "Failed to copy variable types." << std::endl;
+      return -ERR_CPLEX;
+    }
+  }
+  return 0;
+}
+
+int Model::copyTo(CPXCENVptr env, CPXLPptr lp) const {
+  int status = CPXXcopylp(env, lp, numcols, numrows, objsen, obj.data(),
+                          rhs.data(), sense.data(), matbeg.data(),
+                          matcnt.data(), matind.data(), matval.data(),
+                          lb.data(), ub.data(), rngval.data());
+  if (status) {
+    std::cerr << "Failed to copy problem data." << std::endl;
+    return -ERR_CPLEX;
+  }
+  if (! ctype.empty()) {
+    status = CPXXcopyctype(env, lp, ctype.data());
+    if (status) {
+      std::cerr << "Failed to copy variable types." << std::endl;
+      return -ERR_CPLEX;
+    }
+  }
+  return 0;
+}
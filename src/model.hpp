@@ -0,0 +1,57 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+#ifndef MODEL_HPP
+#define MODEL_HPP
+
+#include <vector>
+
+#include <ilcplex/cplexx.h>
+
+/**
+ * An in-memory copy of a CPLEX problem: the constraint matrix (column-wise),
+ * bounds, senses and variable types. It is taken once from the master
+ * problem, after which any number of identical problems can be created in
+ * other CPLEX environments without going back to the filesystem.
+ */
+struct Model {
+  Model() : numcols(0), numrows(0), objsen(CPX_MIN) { }
+
+  /**
+   * Copy the problem in lp into this Model.
+   */
+  int read(CPXCENVptr env, CPXCLPptr lp);
+
+  /**
+   * Load this Model into lp, replacing whatever lp held.
+   */
+  int copyTo(CPXCENVptr env, CPXLPptr lp) const;
+
+  CPXDIM numcols;
+  CPXDIM numrows;
+  int objsen;
+  std::vector<double> obj;
+  std::vector<double> rhs;
+  std::vector<char> sense;
+  std::vector<double> rngval;
+  std::vector<CPXNNZ> matbeg;
+  std::vector<CPXDIM> matcnt;
+  std::vector<CPXDIM> matind;
+  std::vector<double> matval;
+  std::vector<double> lb;
+  std::vector<double> ub;
+  // Empty if the problem is a pure LP.
+  std::vector<char> ctype;
+};
+
+#endif /* MODEL_HPP */
@@ -0,0 +1,99 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+#ifndef POOL_HPP
+#define POOL_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+/**
+ * A slab allocator for objects of type T. Memory is taken from the system in
+ * slabs of SLAB_SIZE objects and never given back while the program runs;
+ * freed objects go on a free list and are reused by the next allocation.
+ *
+ * Boxes and Results are created and destroyed in large numbers by different
+ * threads, so they use a Pool through their own operator new and delete.
+ */
+template<typename T>
+class Pool {
+  public:
+    ~Pool();
+
+    /**
+     * The pool shared by every T.
+     */
+    static Pool & instance();
+
+    void * allocate();
+    void deallocate(void * p);
+
+  private:
+    Pool() : free_(nullptr) { }
+
+    static constexpr size_t SLAB_SIZE = 1024;
+
+    union Slot {
+      Slot * next;
+      alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::mutex mutex_;
+    Slot * free_;
+    std::vector<Slot *> slabs_;
+};
+
+template<typename T>
+inline Pool<T>::~Pool() {
+  for(auto slab: slabs_) {
+    delete[] slab;
+  }
+}
+
+template<typename T>
+inline Pool<T> & Pool<T>::instance() {
+  static Pool pool;
+  return pool;
+}
+
+template<typename T>
+inline void * Pool<T>::allocate() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (free_ == nullptr) {
+    Slot * slab = new Slot[SLAB_SIZE];
+    slabs_.push_back(slab);
+    for(size_t i = 0; i < SLAB_SIZE - 1; ++i) {
+      slab[i].next = &slab[i + 1];
+    }
+    slab[SLAB_SIZE - 1].next = nullptr;
+    free_ = slab;
+  }
+  Slot * s = free_;
+  free_ = s->next;
+  return s;
+}
+
+template<typename T>
+inline void Pool<T>::deallocate(void * p) {
+  if (p == nullptr) {
+    return;
+  }
+  Slot * s = static_cast<Slot *>(p);
+  std::unique_lock<std::mutex> lock(mutex_);
+  s->next = free_;
+  free_ = s;
+}
+
+#endif /* POOL_HPP */
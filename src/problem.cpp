@@ -11,24 +11,50 @@ You should have received a copy of the GNU General Public License along with thi
 
 */
 
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
-#include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "problem.hpp"
 #include "env.hpp"
 #include "errors.hpp"
+#include "lpreader.hpp"
+
+namespace {
+/**
+ * Split line into at most max whitespace-separated fields. Returns how many
+ * were found.
+ */
+int splitFields(const std::string & line, std::string field[], int max) {
+  int count = 0;
+  size_t pos = 0;
+  while (count < max) {
+    size_t start = line.find_first_not_of(" \t\r", pos);
+    if (start == std::string::npos) {
+      break;
+    }
+    pos = line.find_first_of(" \t\r", start);
+    field[count++].assign(line, start, pos - start);
+    if (pos == std::string::npos) {
+      break;
+    }
+  }
+  return count;
+}
+}
 
 Problem::Problem(const char * filename, Env& env):
       objcnt(0), mip_tolerance(1e-4), filename_(filename)
 {
   filetype = UNKNOWN;
   int len = strlen(filename);
-  if ((len > 3) && ('.' == filename[len-3]) &&
-      ('l' == filename[len-2] && 'p' == filename[len-1])) {
+  if (isLPFile(filename)) {
     filetype = LP;
     read_lp_problem(env);
   } else if ((len > 4) && ('.' == filename[len-4]) &&
@@ -37,10 +63,112 @@ Problem::Problem(const char * filename, Env& env):
     filetype = MOP;
     read_mop_problem(env);
   }
+  // The native LP reader fills in model_ itself.
+  if ((env.lp != nullptr) && (model_.numrows == 0)) {
+    model_.read(env.env, env.lp);
+  }
+}
+
+int Problem::clone(Env& e) const {
+  int status;
+  e.lp = CPXXcreateprob(e.env, &status, filename());
+  if (e.lp == nullptr) {
+    std::cerr << "Failed to create LP." << std::endl;
+    return -ERR_CPLEX;
+  }
+  return model_.copyTo(e.env, e.lp);
 }
 
 int Problem::read_lp_problem(Env& e) {
+  switch (readLP(filename(), model_)) {
+    case LP_READ:
+      break;
+    case LP_UNSUPPORTED:
+      return read_lp_with_cplex(e);
+    case LP_FAILED:
+    default:
+      return -ERR_FILE;
+  }
+
+  /* The RHS of the last row is the number of objectives */
+  int cur_numrows = model_.numrows;
+  if ((cur_numrows == 0) || (model_.rhs[cur_numrows-1] < 1) ||
+      (model_.rhs[cur_numrows-1] > cur_numrows)) {
+    std::cerr << "Error: The last row of " << filename() << " doesn't give "
+      "the number of objectives." << std::endl;
+    model_ = Model();
+    return -ERR_FILE;
+  }
+  int count = static_cast<int>(model_.rhs[cur_numrows-1]);
+  int first = cur_numrows - count;
+
+  /* Pick the objective rows out of the column-wise matrix */
+  std::vector<std::vector<int>> ind(count);
+  std::vector<std::vector<double>> coef(count);
+  for(CPXDIM j = 0; j < model_.numcols; ++j) {
+    for(CPXNNZ k = model_.matbeg[j]; k < model_.matbeg[j] + model_.matcnt[j];
+        ++k) {
+      if (model_.matind[k] >= first) {
+        ind[model_.matind[k] - first].push_back(j);
+        coef[model_.matind[k] - first].push_back(model_.matval[k]);
+      }
+    }
+  }
+  objcnt = count;
+  objnzcnt = new int[objcnt];
+  objind = new int*[objcnt];
+  objcoef = new double*[objcnt];
+  for(int j = 0; j < objcnt; j++) {
+    objnzcnt[j] = static_cast<int>(ind[j].size());
+    objind[j] = new int[objnzcnt[j]];
+    objcoef[j] = new double[objnzcnt[j]];
+    std::copy(ind[j].begin(), ind[j].end(), objind[j]);
+    std::copy(coef[j].begin(), coef[j].end(), objcoef[j]);
+  }
+
+  objsen = (model_.objsen == CPX_MIN ? MIN : MAX);
+  /* Set objective constraint sense and RHS */
+  rhs = new double[objcnt];
+  consense = new char[objcnt];
+  conind = new int[objcnt];
+  for (int j = 0; j < objcnt; j++) {
+    if (objsen == MIN) {
+      consense[j] = 'L'; /* Set sense to <= */
+      rhs[j] = CPX_INFBOUND;
+    }
+    else {
+      consense[j] = 'G'; /* Set sense to >= */
+      rhs[j] = -CPX_INFBOUND;
+    }
+    conind[j] = first + j;
+    model_.sense[first + j] = consense[j];
+    model_.rhs[first + j] = rhs[j];
+    model_.rngval[first + j] = 0;
+  }
+
+  /* Without a CPLEX environment the model is all that is needed. Otherwise
+   * hand the whole problem to CPLEX at once */
+  if (e.env == nullptr)
+    return 0;
+  return clone(e);
+}
+
+int Problem::open_cplex(Env& e) {
+  if (e.env != nullptr)
+    return 0;
+  int status;
+  e.env = CPXXopenCPLEX(&status);
+  if (e.env == nullptr) {
+    std::cerr << "Could not open CPLEX environment." << std::endl;
+    return -ERR_CPLEX;
+  }
+  return 0;
+}
+
+int Problem::read_lp_with_cplex(Env& e) {
   int status;
+  if ((status = open_cplex(e)) != 0)
+    return status;
   /* Create the problem, using the filename as the problem name */
   e.lp = CPXcreateprob(e.env, &status, filename());
 
@@ -57,7 +185,6 @@ int Problem::read_lp_problem(Env& e) {
   }
 
   /* Get last rhs and determine the number of objectives.*/
-  int cur_numcols = CPXgetnumcols(e.env, e.lp);
   int cur_numrows = CPXgetnumrows(e.env, e.lp);
   int cur_numnz = CPXgetnumnz(e.env, e.lp);
 
@@ -73,23 +200,6 @@ int Problem::read_lp_problem(Env& e) {
 
   objcnt = static_cast<int>(rhs[0]);
 
-  /* Create a pair of multidimensional arrays to store the objective
-  * coefficients and their indices indices first */
-  objind = new int*[objcnt];
-  for(int j = 0; j < objcnt; j++) {
-    objind[j] = new int[cur_numcols];
-    for(int i = 0; i < cur_numcols; i++){
-      objind[j][i] = i;
-    }
-  }
-  /* Now coefficients */
-  objcoef = new double*[objcnt];
-  for(int j = 0; j < objcnt; j++) {
-    objcoef[j] = new double[cur_numcols];
-    for (int i = 0; i < cur_numcols; ++i)
-      objcoef[j][i] = 0;
-  }
-
   /* Parse out the objectives working backwards from the last constraint */
   int * rmatbeg = new int[cur_numrows];
   int * rmatind = new int[cur_numnz];
@@ -105,17 +215,19 @@ int Problem::read_lp_problem(Env& e) {
     return -ERR_CPLEX;
   }
 
+  /* Keep only the non-zero coefficients of each objective */
+  objnzcnt = new int[objcnt];
+  objind = new int*[objcnt];
+  objcoef = new double*[objcnt];
   for (int j = 0; j < objcnt; j++) {
-    int to;
     int from = rmatbeg[j];
-    if (j == objcnt-1) {
-      to = nzcnt-1;
-    }
-    else {
-      to = rmatbeg[(j+1)] - 1;
-    }
-    for (int k = from; k <= to; k++) {
-      objcoef[j][rmatind[k]] = rmatval[k];
+    int to = (j == objcnt-1) ? nzcnt : rmatbeg[j+1];
+    objnzcnt[j] = to - from;
+    objind[j] = new int[objnzcnt[j]];
+    objcoef[j] = new double[objnzcnt[j]];
+    for (int k = from; k < to; k++) {
+      objind[j][k - from] = rmatind[k];
+      objcoef[j][k - from] = rmatval[k];
     }
   }
   delete[] rmatbeg;
@@ -169,6 +281,8 @@ int Problem::read_lp_problem(Env& e) {
 
 int Problem::read_mop_problem(Env& e) {
   int status;
+  if ((status = open_cplex(e)) != 0)
+    return status;
   /* Create the problem, using the filename as the problem name */
   e.lp = CPXcreateprob(e.env, &status, filename());
 
@@ -177,135 +291,124 @@ int Problem::read_mop_problem(Env& e) {
     return -ERR_CPLEX;
   }
 
-  /* Now read the file, and copy the data into the created lp */
+  /* Now read the file, and copy the data into the created lp. CPLEX keeps
+   * only the first objective, so the rest are read below. */
   status = CPXreadcopyprob(e.env, e.lp, filename(), NULL);
   if (status) {
     std::cerr << "Failed to read and copy the problem data." << std::endl;
     return -ERR_CPLEX;
   }
 
+  int cur_numcols = CPXgetnumcols(e.env, e.lp);
+  int cur_numrows = CPXgetnumrows(e.env, e.lp);
 
-  size_t cur_numcols = CPXgetnumcols(e.env, e.lp);
-  size_t cur_numrows = CPXgetnumrows(e.env, e.lp);
-
-
-  char** colNames = new char*[cur_numcols];
-  size_t sz = cur_numcols * 1024;
-  char* store = new char[sz];
+  // Ask how much space the names need, then get them.
   int surplus;
-  status = CPXgetcolname(e.env, e.lp, colNames, store, sz, &surplus, 0, cur_numcols-1);
-  if (status) {
+  status = CPXgetcolname(e.env, e.lp, NULL, NULL, 0, &surplus, 0,
+                         cur_numcols-1);
+  if ((status != 0) && (status != CPXERR_NEGATIVE_SURPLUS)) {
     std::cerr << "Error retrieving column names." << std::endl;
     return -ERR_CPLEX;
   }
-
-
-  // Iterate through file until we get to ROWS
-  // count number of objectives
-  // store names
-  // break when we get COLUMNS
-  // read a b c
-  // if b == objective_name[i] objcoeff[i][ name_to_index[a]] = int(c)
-  std::fstream mop_file(filename(), std::ios::in);
-  std::string line;
-  // Find "ROWS" line
-  while (std::getline( mop_file, line)) {
-    if ("ROWS" == line) {
-      break;
-    }
-  }
-  // Read objective names
-  std::vector<std::string> objNames;
-  while (std::getline( mop_file, line)) {
-    // Objective functions have N as the second character
-    if ('N' != line[1]) {
-      break;
-    }
-    std::stringstream ss(line);
-    std::string n, name;
-    ss >> n; // Skip "N"
-    ss >> name;
-    objNames.push_back(name);
-  }
-  objcnt = static_cast<int>(objNames.size());
-  int new_nzcnt = objcnt * cur_numcols;
-  double * newRowMatVal = new double[new_nzcnt] {0};
-  int * newRowMatInd = new int[new_nzcnt];
-
-  // We will store each coefficient, in order, so set matrix up
-  for(int i = 0; i < objcnt; ++i) {
-    for(size_t j = 0; j < cur_numcols; ++j) {
-      newRowMatInd[i*cur_numcols + j] = j;
-    }
+  std::vector<char*> colNames(cur_numcols);
+  std::vector<char> store(-surplus);
+  status = CPXgetcolname(e.env, e.lp, colNames.data(), store.data(),
+                         store.size(), &surplus, 0, cur_numcols-1);
+  if (status) {
+    std::cerr << "Error retrieving column names." << std::endl;
+    return -ERR_CPLEX;
   }
-  int * newRowMatBeg = new int[objNames.size()];
-  for(int i = 0; i < objcnt; ++i) {
-    newRowMatBeg[i] = i*cur_numcols;
+  std::unordered_map<std::string, int> colIndex;
+  colIndex.reserve(cur_numcols);
+  for(int j = 0; j < cur_numcols; ++j) {
+    colIndex.emplace(colNames[j], j);
   }
 
-  /* Create a pair of multidimensional arrays to store the objective
-  * coefficients and their indices indices first */
-  objind = new int*[objcnt];
-  for(int j = 0; j < objcnt; j++) {
-    objind[j] = new int[cur_numcols];
-    for(size_t i = 0; i < cur_numcols; i++){
-      objind[j][i] = i;
-    }
-  }
-  /* Now coefficients */
-  objcoef = new double*[objcnt];
-  for(int j = 0; j < objcnt; j++) {
-    objcoef[j] = new double[cur_numcols];
-    for (size_t i = 0; i < cur_numcols; ++i) {
-      objcoef[j][i] = 0;
-    }
+  // One pass through the file: the N rows in ROWS are the objectives, and
+  // their coefficients are in COLUMNS.
+  std::ifstream mop_file(filename());
+  if (! mop_file) {
+    std::cerr << "Failed to open " << filename() << std::endl;
+    return -ERR_FILE;
   }
-  // Find columns
-  while (std::getline( mop_file, line)) {
-    if ("COLUMNS" == line) {
-      break;
+  std::unordered_map<std::string, int> objIndex;
+  std::vector<std::string> objNames;
+  std::vector<std::vector<int>> ind;
+  std::vector<std::vector<double>> coef;
+  enum { HEADER, ROWS, COLUMNS } section = HEADER;
+  std::string line;
+  std::string field[5];
+  while (std::getline(mop_file, line)) {
+    if (line.empty() || (line[0] == '*')) {
+      continue;
     }
-  }
-
-  /* Parse out the objectives working backwards from the last constraint */
-  while (std::getline( mop_file, line)) {
-    std::stringstream ss(line);
-    std::string col, obj;
-    signed int val;
-    ss >> col;
-    ss >> obj;
-    ss >> val;
-    size_t colInd;
-    int objInd;
-    for(colInd = 0; colInd < cur_numcols; ++colInd) {
-      if ( col.compare(colNames[colInd]) == 0) {
+    if (! isspace(static_cast<unsigned char>(line[0]))) {
+      // A section header.
+      if (line.compare(0, 4, "ROWS") == 0) {
+        section = ROWS;
+      } else if (line.compare(0, 7, "COLUMNS") == 0) {
+        section = COLUMNS;
+        ind.resize(objNames.size());
+        coef.resize(objNames.size());
+      } else if (section == COLUMNS) {
+        // Nothing after COLUMNS mentions the objectives.
         break;
+      } else {
+        section = HEADER;
       }
+      continue;
     }
-    // Skip if we don't recognise because why not?
-    if (colInd == cur_numcols)
+    if (section == HEADER) {
       continue;
-
-    for(objInd = 0; objInd < objcnt; ++objInd) {
-      if (objNames[objInd] == obj) {
-        break;
+    }
+    int fields = splitFields(line, field, 5);
+    if (section == ROWS) {
+      if ((fields == 2) && (field[0] == "N")) {
+        objIndex.emplace(field[1], objNames.size());
+        objNames.push_back(field[1]);
       }
+      continue;
     }
-    if (objInd == objcnt) {
-      // Just an inequality, which we've already read.
+    // COLUMNS lines are a column then one or two (row, value) pairs.
+    auto col = colIndex.find(field[0]);
+    if (col == colIndex.end()) {
+      // Integer markers, or something CPLEX didn't keep.
       continue;
     }
-    objcoef[objInd][colInd] = val;
-    newRowMatVal[objInd * cur_numcols + colInd] = val;
+    for(int f = 1; f + 1 < fields; f += 2) {
+      auto obj = objIndex.find(field[f]);
+      if (obj == objIndex.end()) {
+        // Just an inequality, which CPLEX has already read.
+        continue;
+      }
+      ind[obj->second].push_back(col->second);
+      coef[obj->second].push_back(strtod(field[f+1].c_str(), NULL));
+    }
+  }
+  objcnt = static_cast<int>(objNames.size());
+  ind.resize(objcnt);
+  coef.resize(objcnt);
+
+  objnzcnt = new int[objcnt];
+  objind = new int*[objcnt];
+  objcoef = new double*[objcnt];
+  std::vector<CPXNNZ> rmatbeg(objcnt);
+  std::vector<CPXDIM> rmatind;
+  std::vector<double> rmatval;
+  for(int j = 0; j < objcnt; j++) {
+    objnzcnt[j] = static_cast<int>(ind[j].size());
+    objind[j] = new int[objnzcnt[j]];
+    objcoef[j] = new double[objnzcnt[j]];
+    std::copy(ind[j].begin(), ind[j].end(), objind[j]);
+    std::copy(coef[j].begin(), coef[j].end(), objcoef[j]);
+    rmatbeg[j] = rmatind.size();
+    rmatind.insert(rmatind.end(), ind[j].begin(), ind[j].end());
+    rmatval.insert(rmatval.end(), coef[j].begin(), coef[j].end());
   }
 
   // Now we need to set up the RHS.
   rhs = new double[objcnt];
 
-  if (status) {
-    std::cerr << "Failed to get RHS." << std::endl;
-    return -ERR_CPLEX;
-  }
   /* Get objective sense */
   int cpx_sense = CPXgetobjsen(e.env, e.lp);
   objsen = (cpx_sense == CPX_MIN ? MIN : MAX);
@@ -322,32 +425,22 @@ int Problem::read_mop_problem(Env& e) {
     }
   }
 
-  delete[] colNames;
-  colNames = new char*[objNames.size()];
-  for(size_t i = 0; i < objNames.size(); ++i) {
-    colNames[i] = new char[objNames[i].size()+1];
-    for(size_t j = 0; j < objNames[i].size(); j++) {
-      colNames[i][j] = objNames[i][j];
-    }
-    colNames[i][objNames.size()] = '\0';
+  std::vector<char*> rowNames(objcnt);
+  for(int j = 0; j < objcnt; ++j) {
+    rowNames[j] = &objNames[j][0];
+  }
+  status = CPXXaddrows(e.env, e.lp, 0 /*ccnt*/, objcnt, rmatind.size(), rhs,
+                       consense, rmatbeg.data(), rmatind.data(),
+                       rmatval.data(), NULL /*colname*/, rowNames.data());
+  if (status) {
+    std::cerr << "Failed to add objective rows" << std::endl;
+    return -ERR_CPLEX;
   }
-  CPXaddrows(e.env, e.lp, 0 /*ccnt*/, objNames.size(), new_nzcnt, rhs, consense, newRowMatBeg, newRowMatInd, newRowMatVal, colNames, NULL /*rowname*/);
 
   conind = new int[objcnt];
   /* Specify index of objective constraints */
   for (int j = 0; j < objcnt; j++) {
     conind[j] = cur_numrows+j;
   }
-
-  /* Set sense of objective constraints */
-  status = CPXchgsense (e.env, e.lp, objcnt, conind, consense);
-  if (status) {
-    std::cerr << "Failed to change constraint sense" << std::endl;
-    return -ERR_CPLEX;
-  }
-
-  delete[] newRowMatVal;
-  delete[] newRowMatInd;
-  delete[] newRowMatBeg;
   return 0;
 }
@@ -18,6 +18,7 @@ You should have received a copy of the GNU General Public License along with thi
 
 #include "sense.hpp"
 #include "env.hpp"
+#include "model.hpp"
 
 enum filetype_t { UNKNOWN, LP, MOP };
 
@@ -25,6 +26,9 @@ class Problem {
   public:
     int objcnt; // Number of objectives
     double* rhs;
+    // Objective j has objnzcnt[j] non-zero coefficients, objcoef[j][k] on
+    // column objind[j][k].
+    int* objnzcnt;
     int** objind; // Objective indices
     double** objcoef; // Objective coefficients
     Sense objsen; // Objective sense. Note that all objectives must have the same
@@ -37,25 +41,52 @@ class Problem {
 
     filetype_t filetype;
 
-    const char* filename();
+    const char* filename() const;
 
+    /**
+     * Read the problem in filename. If env.env is null, LP files that the
+     * native reader can handle are read into memory only, and CPLEX is
+     * opened (in env.env) only for files that need it.
+     */
     Problem(const char* filename, Env& env);
     ~Problem();
     void close(Env &e);
 
+    /**
+     * Create a copy of this problem, as it was when it was read, in the
+     * environment e.env and store it in e.lp. The copy is made from memory,
+     * so the problem file is not read again.
+     */
+    int clone(Env &e) const;
+
+    /**
+     * The problem as it was when it was read.
+     */
+    const Model & model() const;
+
   private:
     int read_lp_problem(Env& e);
+    // For LP files that readLP can't handle.
+    int read_lp_with_cplex(Env& e);
     int read_mop_problem(Env& e);
+    // Opens CPLEX in e.env unless it is already open.
+    static int open_cplex(Env& e);
     const char* filename_;
+    Model model_;
 
 };
 
-inline const char * Problem::filename() {
+inline const char * Problem::filename() const {
   return filename_;
 }
 
+inline const Model & Problem::model() const {
+  return model_;
+}
+
 inline void Problem::close(Env &e) {
-  CPXXfreeprob(e.env, &e.lp);
+  if (e.lp != nullptr)
+    CPXXfreeprob(e.env, &e.lp);
 }
 
 inline Problem::~Problem() {
@@ -66,6 +97,7 @@ inline Problem::~Problem() {
     delete[] objind[j];
     delete[] objcoef[j];
   }
+  delete[] objnzcnt;
   delete[] objind;
   delete[] objcoef;
   delete[] rhs;
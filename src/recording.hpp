@@ -0,0 +1,271 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+
+#ifndef RECORDING_HPP
+#define RECORDING_HPP
+
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ilcplex/cplexx.h>
+
+#include "archive.hpp"
+#include "box.hpp"
+#include "result.hpp"
+#include "sense.hpp"
+
+/*
+ * A recording holds the answer to every box solved in a run, so that the run
+ * can be replayed without a solver. It is a text file:
+ *   # boxsplit recording
+ *   N sense utopia[N]
+ * and then one line per solved box:
+ *   u[N] seconds count point[N]...
+ * where count is 0 if the box held no point, and otherwise the number of
+ * points found in it (more than one with --pool), each given as N values.
+ */
+
+/**
+ * The number of objectives in the recording in filename, or 0 if it can't be
+ * read.
+ */
+inline int recordedObjectives(const std::string & filename) {
+  std::ifstream in(filename);
+  std::string header;
+  std::getline(in, header);
+  int objcnt = 0;
+  in >> objcnt;
+  return in.good() ? objcnt : 0;
+}
+
+/**
+ * Writes a recording as boxes are solved. Only used by the JobServer's
+ * coordinator, so needs no locking.
+ */
+template<int N>
+class Recorder {
+  public:
+    Recorder(const std::string & filename, Sense sense, const CPXLONG utopia[]);
+
+    bool good() const { return out_.good(); }
+
+    /**
+     * Record the answer to the box of res. Must be called before the
+     * JobServer takes the extra points from res.
+     */
+    void write(Result<N> * res);
+
+  private:
+    std::ofstream out_;
+};
+
+/**
+ * Answers boxes from a recording. If a box was not solved in the recorded
+ * run (because points were found in another order, so boxes were split
+ * differently), the answer is the recorded point inside the box with the best
+ * sum of objective values, or no point if there is none. Every recorded point
+ * is nondominated, so this is always a correct answer.
+ *
+ * Once read, a Replay is only read, so any number of workers can share one.
+ */
+template<int N>
+class Replay {
+  public:
+    Replay() : sense(MIN), points_(MIN), seconds_(0) { }
+    ~Replay();
+
+    bool read(const std::string & filename);
+
+    /**
+     * The answer to box, after waiting for latency times the recorded solve
+     * time. An empty Result if there is no point inside box.
+     */
+    Result<N> * solve(Box<N> * box, double latency) const;
+
+    // As recorded.
+    Sense sense;
+    CPXLONG utopia[N];
+
+  private:
+    struct Answer {
+      double seconds;
+      std::vector<std::array<CPXLONG, N>> points;
+    };
+
+    std::map<std::array<CPXLONG, N>, Answer> answers_;
+    // Every recorded point, for boxes that were not recorded.
+    Archive<N> points_;
+    // The mean solve time, for boxes that were not recorded.
+    double seconds_;
+};
+
+template<int N>
+inline Recorder<N>::Recorder(const std::string & filename, Sense sense,
+    const CPXLONG utopia[]) : out_(filename) {
+  out_ << "# boxsplit recording" << std::endl;
+  out_ << N << " " << static_cast<int>(sense);
+  for(int i = 0; i < N; ++i) {
+    out_ << " " << utopia[i];
+  }
+  out_ << std::endl << std::setprecision(9);
+}
+
+template<int N>
+inline void Recorder<N>::write(Result<N> * res) {
+  const Box<N> * box = res->box();
+  for(int i = 0; i < N; ++i) {
+    out_ << box->u[i] << " ";
+  }
+  out_ << res->seconds << " ";
+  if (res->isEmpty()) {
+    out_ << 0 << "\n";
+    return;
+  }
+  out_ << 1 + res->extra.size();
+  for(int i = 0; i < N; ++i) {
+    out_ << " " << res->soln[i];
+  }
+  for(auto r: res->extra) {
+    for(int i = 0; i < N; ++i) {
+      out_ << " " << r->soln[i];
+    }
+  }
+  out_ << "\n";
+}
+
+template<int N>
+inline Replay<N>::~Replay() {
+  for(auto r: points_.take()) {
+    delete r;
+  }
+}
+
+template<int N>
+inline bool Replay<N>::read(const std::string & filename) {
+  std::ifstream in(filename);
+  std::string header;
+  std::getline(in, header);
+  int objcnt, senseValue;
+  in >> objcnt >> senseValue;
+  if (! in.good() || (header != "# boxsplit recording")) {
+    std::cerr << "Error: " << filename << " is not a recording." << std::endl;
+    return false;
+  }
+  if (objcnt != N) {
+    std::cerr << "Error: " << filename << " was recorded with " << objcnt
+      << " objectives." << std::endl;
+    return false;
+  }
+  sense = static_cast<Sense>(senseValue);
+  points_ = Archive<N>(sense);
+  for(int i = 0; i < N; ++i) {
+    in >> utopia[i];
+  }
+  std::array<CPXLONG, N> u;
+  double total = 0;
+  while (in >> u[0]) {
+    for(int i = 1; i < N; ++i) {
+      in >> u[i];
+    }
+    Answer answer;
+    size_t count;
+    in >> answer.seconds >> count;
+    answer.points.resize(count);
+    for(auto & p: answer.points) {
+      for(int i = 0; i < N; ++i) {
+        in >> p[i];
+      }
+      auto * r = new Result<N>(nullptr, p.data());
+      if (! points_.insert(r)) {
+        delete r;
+      }
+    }
+    if (in.fail()) {
+      std::cerr << "Error: " << filename << " is truncated." << std::endl;
+      return false;
+    }
+    total += answer.seconds;
+    answers_[u] = std::move(answer);
+  }
+  if (! answers_.empty()) {
+    seconds_ = total / answers_.size();
+  }
+  return true;
+}
+
+template<int N>
+inline Result<N> * Replay<N>::solve(Box<N> * box, double latency) const {
+  std::array<CPXLONG, N> u;
+  for(int i = 0; i < N; ++i) {
+    u[i] = box->u[i];
+  }
+  CPXLONG none[N];
+  for(int i = 0; i < N; ++i) {
+    none[i] = -1;
+  }
+  Result<N> * res;
+  double seconds;
+  auto found = answers_.find(u);
+  if (found != answers_.end()) {
+    seconds = found->second.seconds;
+    const auto & points = found->second.points;
+    if (points.empty()) {
+      res = new Result<N>(box, none);
+    } else {
+      res = new Result<N>(box, points[0].data());
+      for(size_t k = 1; k < points.size(); ++k) {
+        res->extra.push_back(new Result<N>(nullptr, points[k].data()));
+      }
+    }
+  } else {
+    seconds = seconds_;
+    // Boxes the recorded run never solved are rare, so scanning every
+    // recorded point is cheap enough.
+    std::vector<Result<N> *> known;
+    points_.all(known);
+    const Result<N> * best = nullptr;
+    CPXLONG bestSum = 0;
+    for(auto r: known) {
+      if ((sense == MIN) ? ! box->less_than_u(r->soln) :
+          ! box->greater_than_u(r->soln)) {
+        continue;
+      }
+      CPXLONG sum = 0;
+      for(int i = 0; i < N; ++i) {
+        sum += r->soln[i];
+      }
+      if ((best == nullptr) || ((sense == MIN) && (sum < bestSum)) ||
+          ((sense == MAX) && (sum > bestSum))) {
+        best = r;
+        bestSum = sum;
+      }
+    }
+    res = new Result<N>(box, best ? best->soln : none);
+  }
+  if (latency > 0) {
+    std::this_thread::sleep_for(
+        std::chrono::duration<double>(seconds * latency));
+  }
+  res->seconds = seconds;
+  return res;
+}
+
+#endif /* RECORDING_HPP */
@@ -0,0 +1,216 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "remote.hpp"
+
+static const std::string UNIX_PREFIX = "unix:";
+
+/**
+ * Fill in addr for the Unix domain socket at path.
+ */
+static bool unixAddress(const std::string & path, sockaddr_un & addr) {
+  if (path.size() >= sizeof(addr.sun_path)) {
+    std::cerr << "Socket path " << path << " is too long." << std::endl;
+    return false;
+  }
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  return true;
+}
+
+int listenOn(const std::string & address) {
+  int fd;
+  if (address.compare(0, UNIX_PREFIX.size(), UNIX_PREFIX) == 0) {
+    sockaddr_un addr;
+    std::string path = address.substr(UNIX_PREFIX.size());
+    if (! unixAddress(path, addr)) {
+      return -1;
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+      std::cerr << "Failed to create socket: " << std::strerror(errno)
+        << std::endl;
+      return -1;
+    }
+    // A socket left over from an earlier run would stop us binding.
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+      std::cerr << "Failed to bind to " << path << ": "
+        << std::strerror(errno) << std::endl;
+      close(fd);
+      return -1;
+    }
+  } else {
+    // [host:]port
+    std::string host, port = address;
+    auto colon = address.rfind(':');
+    if (colon != std::string::npos) {
+      host = address.substr(0, colon);
+      port = address.substr(colon + 1);
+    }
+    addrinfo hints, *res;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    int status = getaddrinfo(host.empty() ? nullptr : host.c_str(),
+                             port.c_str(), &hints, &res);
+    if (status != 0) {
+      std::cerr << "Failed to resolve " << address << ": "
+        << gai_strerror(status) << std::endl;
+      return -1;
+    }
+    fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (fd < 0) {
+      std::cerr << "Failed to create socket: " << std::strerror(errno)
+        << std::endl;
+      freeaddrinfo(res);
+      return -1;
+    }
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    if (bind(fd, res->ai_addr, res->ai_addrlen) != 0) {
+      std::cerr << "Failed to bind to " << address << ": "
+        << std::strerror(errno) << std::endl;
+      freeaddrinfo(res);
+      close(fd);
+      return -1;
+    }
+    freeaddrinfo(res);
+  }
+  if (listen(fd, 64) != 0) {
+    std::cerr << "Failed to listen on " << address << ": "
+      << std::strerror(errno) << std::endl;
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int connectTo(const std::string & address) {
+  int fd;
+  if (address.compare(0, UNIX_PREFIX.size(), UNIX_PREFIX) == 0) {
+    sockaddr_un addr;
+    if (! unixAddress(address.substr(UNIX_PREFIX.size()), addr)) {
+      return -1;
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+      std::cerr << "Failed to create socket: " << std::strerror(errno)
+        << std::endl;
+      return -1;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+      std::cerr << "Failed to connect to " << address << ": "
+        << std::strerror(errno) << std::endl;
+      close(fd);
+      return -1;
+    }
+    return fd;
+  }
+  auto colon = address.rfind(':');
+  if (colon == std::string::npos) {
+    std::cerr << "Address " << address << " must be host:port or unix:path."
+      << std::endl;
+    return -1;
+  }
+  std::string host = address.substr(0, colon);
+  std::string port = address.substr(colon + 1);
+  addrinfo hints, *res;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  int status = getaddrinfo(host.c_str(), port.c_str(), &hints, &res);
+  if (status != 0) {
+    std::cerr << "Failed to resolve " << address << ": "
+      << gai_strerror(status) << std::endl;
+    return -1;
+  }
+  fd = -1;
+  for(addrinfo * ai = res; ai != nullptr; ai = ai->ai_next) {
+    fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+    if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+      break;
+    }
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+  if (fd < 0) {
+    std::cerr << "Failed to connect to " << address << std::endl;
+  }
+  return fd;
+}
+
+bool sendWords(int fd, const CPXLONG * words, size_t count) {
+  const char * buf = reinterpret_cast<const char *>(words);
+  size_t left = count * sizeof(CPXLONG);
+  while (left > 0) {
+    ssize_t sent = send(fd, buf, left, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    buf += sent;
+    left -= sent;
+  }
+  return true;
+}
+
+bool recvWords(int fd, CPXLONG * words, size_t count) {
+  char * buf = reinterpret_cast<char *>(words);
+  size_t left = count * sizeof(CPXLONG);
+  while (left > 0) {
+    ssize_t got = recv(fd, buf, left, 0);
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    if (got == 0) {
+      // The other end has gone away.
+      return false;
+    }
+    buf += got;
+    left -= got;
+  }
+  return true;
+}
+
+void closeConnection(int fd) {
+  close(fd);
+}
+
+void shutdownListener(int fd) {
+  shutdown(fd, SHUT_RDWR);
+  close(fd);
+}
@@ -0,0 +1,184 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+#ifndef REMOTE_HPP
+#define REMOTE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ilcplex/cplexx.h>
+
+#include "box.hpp"
+#include "boxfinder.hpp"
+#include "problem.hpp"
+#include "result.hpp"
+#include "sense.hpp"
+#include "solver.hpp"
+
+extern std::atomic<int> ipcount;
+
+/*
+ * Distributed mode. A coordinator (--listen) owns the box decomposition, and
+ * worker processes (--connect) solve boxes for it. Each worker connection is
+ * served by its own thread in the coordinator, which takes jobs from the same
+ * queue as local workers.
+ *
+ * Every message is a sequence of CPXLONG words, in the byte order of the
+ * machines involved (which must match):
+ *   hello (coordinator to worker): REMOTE_MAGIC, N, sense, utopia[N]
+ *   ready (worker to coordinator): REMOTE_MAGIC, or 0 if the worker can't
+ *                                  solve this problem
+ *   box   (coordinator to worker): MSG_BOX, u[N]
+ *   stop  (coordinator to worker): MSG_STOP
+ *   reply (worker to coordinator): status, IPs solved, soln[N], number of
+ *                                  extra points, then soln[N] for each
+ * status is REPLY_POINT if soln is a new point and REPLY_EMPTY if the box
+ * holds no point.
+ *
+ * Addresses are either [host:]port for TCP, or unix:path for a Unix domain
+ * socket.
+ */
+const CPXLONG REMOTE_MAGIC = 0x424f58574f524b31LL; // "BOXWORK1"
+enum MessageType { MSG_STOP = 0, MSG_BOX = 1 };
+// The most extra points a reply may carry. A worker sending more is broken.
+const CPXLONG REMOTE_MAX_EXTRAS = 1 << 16;
+enum ReplyStatus { REPLY_POINT = 0, REPLY_EMPTY = 1 };
+
+/**
+ * Open a socket listening on address. Returns the file descriptor, or -1
+ * after printing an error.
+ */
+int listenOn(const std::string & address);
+
+/**
+ * Connect to address. Returns the file descriptor, or -1 after printing an
+ * error.
+ */
+int connectTo(const std::string & address);
+
+/**
+ * Send or receive exactly count words. Return false if the connection
+ * failed.
+ */
+bool sendWords(int fd, const CPXLONG * words, size_t count);
+bool recvWords(int fd, CPXLONG * words, size_t count);
+
+void closeConnection(int fd);
+
+/**
+ * Stop a listening socket, waking any thread blocked in accept().
+ */
+void shutdownListener(int fd);
+
+/**
+ * Serve one connection to a coordinator: solve every box it sends until it
+ * says to stop.
+ */
+template<int N>
+int remoteWorker(const std::string & address, const Problem & p,
+    bool harvestPool, Backend backend) {
+  int fd = connectTo(address);
+  if (fd < 0) {
+    return 1;
+  }
+  CPXLONG hello[3 + N];
+  if (! recvWords(fd, hello, 3 + N) || (hello[0] != REMOTE_MAGIC)) {
+    std::cerr << "Error: " << address << " is not a boxfinder coordinator."
+      << std::endl;
+    closeConnection(fd);
+    return 1;
+  }
+  Sense sense = (hello[2] == MIN) ? MIN : MAX;
+  CPXLONG ready = REMOTE_MAGIC;
+  if ((hello[1] != N) || (sense != p.objsen)) {
+    std::cerr << "Error: The coordinator at " << address << " is solving a "
+      "different problem." << std::endl;
+    ready = 0;
+    sendWords(fd, &ready, 1);
+    closeConnection(fd);
+    return 1;
+  }
+  if (! sendWords(fd, &ready, 1)) {
+    closeConnection(fd);
+    return 1;
+  }
+  CPXLONG * utopia = hello + 3;
+  Solver * solver = Solver::create(backend, p, utopia);
+  std::vector<CPXLONG> reply;
+  for (;;) {
+    CPXLONG type;
+    if (! recvWords(fd, &type, 1) || (type != MSG_BOX)) {
+      break;
+    }
+    CPXLONG u[N];
+    if (! recvWords(fd, u, N)) {
+      break;
+    }
+    // Only u is needed to solve a box.
+    Box<N> box(u, u);
+    BoxFinder<N> finder(p.filename(), p.objsen, nullptr, *solver, &box,
+        std::vector<Result<N> *>(), false, harvestPool);
+    Result<N> * res = finder();
+    reply.clear();
+    reply.push_back(res->isEmpty() ? REPLY_EMPTY : REPLY_POINT);
+    // Other connections in this process add to ipcount at the same time, so
+    // only count this box's IPs.
+    reply.push_back(finder.solved());
+    reply.insert(reply.end(), res->soln, res->soln + N);
+    // Any points beyond the limit are simply found again later.
+    size_t extras = std::min(res->extra.size(),
+        static_cast<size_t>(REMOTE_MAX_EXTRAS));
+    reply.push_back(extras);
+    for(size_t k = 0; k < extras; ++k) {
+      reply.insert(reply.end(), res->extra[k]->soln,
+          res->extra[k]->soln + N);
+    }
+    delete res;
+    if (! sendWords(fd, reply.data(), reply.size())) {
+      break;
+    }
+  }
+  closeConnection(fd);
+  delete solver;
+  return 0;
+}
+
+/**
+ * Run threads connections to the coordinator at address, each with its own
+ * solver, until the coordinator stops them.
+ */
+template<int N>
+int remoteWorkers(const std::string & address, const Problem & p,
+    int threads, bool harvestPool, Backend backend) {
+  std::vector<std::thread> connections;
+  std::atomic<int> failures(0);
+  for(int t = 0; t < threads; ++t) {
+    connections.emplace_back([&] {
+        if (remoteWorker<N>(address, p, harvestPool, backend) != 0) {
+          failures += 1;
+        }
+      });
+  }
+  for(auto & c: connections) {
+    c.join();
+  }
+  return (failures == threads) ? 1 : 0;
+}
+
+#endif /* REMOTE_HPP */
@@ -14,31 +14,78 @@ You should have received a copy of the GNU General Public License along with thi
 #ifndef RESULT_HPP
 #define RESULT_HPP
 
+#include <vector>
+
 #include <ilcplex/cplexx.h>
 
-class Box;
+#include "pool.hpp"
+
+template<int N> struct Box;
 
+template<int N>
 class Result {
   public:
-    Result(Box *box, CPXLONG soln_[]);
+    Result(Box<N> *box, const CPXLONG soln_[]);
     ~Result();
-    CPXLONG * soln;
-    Box * box() { return box_; }
+    CPXLONG soln[N];
+    // The values of the problem's own variables at this solution. This is
+    // only filled in when solutions are kept for warm-starting other boxes.
+    std::vector<double> x;
+    // Further nondominated points found while solving the same box. These
+    // are owned by this Result until the JobServer takes them.
+    std::vector<Result *> extra;
+    // Whether the solve was interrupted because the box was split while it
+    // ran. A cancelled Result holds no point.
+    bool cancelled;
+    // Wall-clock time spent solving the box.
+    double seconds;
+    Box<N> * box() { return box_; }
+    // Whether this holds no point, i.e. the box was empty or the solve was
+    // cancelled.
+    bool isEmpty() const;
+    // Link to the next Result while this one is in a ResultQueue.
+    Result * next;
+
+    // Results come from a Pool rather than the global allocator.
+    static void * operator new(size_t size);
+    static void operator delete(void * p);
 
   private:
-    Box * box_;
+    Box<N> * box_;
 };
 
-inline Result::Result(Box *box, CPXLONG soln_[]) :
-  box_(box) {
-  this->soln = new CPXLONG[3];
-  for(int i = 0; i < 3; ++i) {
+template<int N>
+inline Result<N>::Result(Box<N> *box, const CPXLONG soln_[]) :
+  cancelled(false), seconds(0), next(nullptr), box_(box) {
+  for(int i = 0; i < N; ++i) {
     this->soln[i] = soln_[i];
   }
 }
 
-inline Result::~Result() {
-  delete[] this->soln;
+template<int N>
+inline bool Result<N>::isEmpty() const {
+  bool empty = true;
+  for(int i = 0; i < N; ++i) {
+    empty &= (soln[i] == -1);
+  }
+  return empty;
+}
+
+template<int N>
+inline Result<N>::~Result() {
+  for(auto r: extra) {
+    delete r;
+  }
+}
+
+template<int N>
+inline void * Result<N>::operator new(size_t) {
+  return Pool<Result<N>>::instance().allocate();
+}
+
+template<int N>
+inline void Result<N>::operator delete(void * p) {
+  Pool<Result<N>>::instance().deallocate(p);
 }
 
 
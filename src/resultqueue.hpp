@@ -0,0 +1,76 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+#ifndef RESULTQUEUE_HPP
+#define RESULTQUEUE_HPP
+
+#include <atomic>
+
+#include "result.hpp"
+
+/**
+ * A lock-free queue of Results, with many producers (the workers) and a
+ * single consumer (the JobServer's coordinator). Producers push onto an
+ * intrusive stack through Result::next with a compare-and-swap, and the
+ * consumer takes the whole stack in one exchange and reverses it, so Results
+ * come out in the order they were pushed.
+ *
+ * All operations are sequentially consistent, as the coordinator relies on
+ * seeing either a push or the worker seeing that it has gone to sleep.
+ */
+template<int N>
+class ResultQueue {
+  public:
+    ResultQueue() : head_(nullptr) { }
+
+    void push(Result<N> * r);
+
+    /**
+     * Take every Result pushed so far. They are returned as a list linked
+     * through Result::next, oldest first, or nullptr if there are none.
+     */
+    Result<N> * popAll();
+
+    bool empty() const;
+
+  private:
+    std::atomic<Result<N> *> head_;
+};
+
+template<int N>
+inline void ResultQueue<N>::push(Result<N> * r) {
+  Result<N> * head = head_.load();
+  do {
+    r->next = head;
+  } while (! head_.compare_exchange_weak(head, r));
+}
+
+template<int N>
+inline Result<N> * ResultQueue<N>::popAll() {
+  Result<N> * head = head_.exchange(nullptr);
+  Result<N> * reversed = nullptr;
+  while (head != nullptr) {
+    Result<N> * next = head->next;
+    head->next = reversed;
+    reversed = head;
+    head = next;
+  }
+  return reversed;
+}
+
+template<int N>
+inline bool ResultQueue<N>::empty() const {
+  return head_.load() == nullptr;
+}
+
+#endif /* RESULTQUEUE_HPP */
@@ -0,0 +1,306 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <list>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include <ilcplex/cplexx.h>
+
+#include "box.hpp"
+#include "sense.hpp"
+
+/**
+ * The order in which boxes waiting to be solved are handed out:
+ * FIFO - in the order they were created
+ * VOLUME - largest volume in objective space first
+ * DEPTH - most deeply split first, to keep the number of live boxes down
+ * YIELD - boxes at the depth that has most often led to new points so far
+ */
+enum Policy { FIFO, VOLUME, DEPTH, YIELD };
+
+/**
+ * Holds the boxes that are waiting to be solved, for a problem with N
+ * objectives, and decides which is solved next. Schedulers are only used
+ * by the JobServer's coordinator, so need no locking.
+ */
+template<int N>
+class Scheduler {
+  public:
+    virtual ~Scheduler() { }
+
+    virtual void push(Box<N> * b) = 0;
+    /**
+     * Remove and return the next box to solve. The scheduler must not be
+     * empty.
+     */
+    virtual Box<N> * pop() = 0;
+    virtual bool empty() const = 0;
+    virtual size_t size() const = 0;
+
+    /**
+     * Told once a box has been solved, with whether a new point was found.
+     */
+    virtual void solved(const Box<N> * /* b */, bool /* found */) { }
+
+    static Scheduler * create(Policy policy, Sense sense, const CPXLONG * utopia);
+};
+
+template<int N>
+class FifoScheduler : public Scheduler<N> {
+  public:
+    void push(Box<N> * b) override { boxes_.push_back(b); }
+    Box<N> * pop() override;
+    bool empty() const override { return boxes_.empty(); }
+    size_t size() const override { return boxes_.size(); }
+
+  private:
+    std::list<Box<N> *> boxes_;
+};
+
+/**
+ * Hands out the box with the largest key first. Boxes with equal keys are
+ * handed out in the order they were pushed.
+ */
+template<int N>
+class PriorityScheduler : public Scheduler<N> {
+  public:
+    PriorityScheduler() : count_(0) { }
+
+    void push(Box<N> * b) override;
+    Box<N> * pop() override;
+    bool empty() const override { return heap_.empty(); }
+    size_t size() const override { return heap_.size(); }
+
+  protected:
+    virtual double key(const Box<N> * b) const = 0;
+
+  private:
+    struct Entry {
+      double key;
+      uint64_t seq;
+      Box<N> * box;
+      bool operator<(const Entry & other) const {
+        if (key != other.key) {
+          return key < other.key;
+        }
+        return seq > other.seq;
+      }
+    };
+    std::priority_queue<Entry> heap_;
+    uint64_t count_;
+};
+
+/**
+ * The volume of a box is measured between its u corner and the utopia point.
+ */
+template<int N>
+class VolumeScheduler : public PriorityScheduler<N> {
+  public:
+    VolumeScheduler(Sense sense, const CPXLONG * utopia);
+
+  protected:
+    double key(const Box<N> * b) const override;
+
+  private:
+    Sense sense_;
+    CPXLONG utopia_[N];
+};
+
+template<int N>
+class DepthScheduler : public PriorityScheduler<N> {
+  protected:
+    double key(const Box<N> * b) const override { return b->depth; }
+};
+
+/**
+ * Keeps one queue per depth, and estimates the chance that solving a box at
+ * each depth finds a new point from the boxes solved so far at that depth.
+ * pop() takes the oldest box from the depth with the best estimate, so the
+ * order adapts as the run goes on.
+ */
+template<int N>
+class YieldScheduler : public Scheduler<N> {
+  public:
+    YieldScheduler() : size_(0) { }
+
+    void push(Box<N> * b) override;
+    Box<N> * pop() override;
+    bool empty() const override { return size_ == 0; }
+    size_t size() const override { return size_; }
+    void solved(const Box<N> * b, bool found) override;
+
+  private:
+    double estimate(size_t depth) const;
+
+    std::vector<std::deque<Box<N> *>> queues_;
+    std::vector<size_t> solved_;
+    std::vector<size_t> found_;
+    size_t size_;
+};
+
+template<int N>
+inline Box<N> * FifoScheduler<N>::pop() {
+  Box<N> * b = boxes_.front();
+  boxes_.pop_front();
+  return b;
+}
+
+template<int N>
+inline void PriorityScheduler<N>::push(Box<N> * b) {
+  heap_.push(Entry{key(b), count_++, b});
+}
+
+template<int N>
+inline Box<N> * PriorityScheduler<N>::pop() {
+  Box<N> * b = heap_.top().box;
+  heap_.pop();
+  return b;
+}
+
+template<int N>
+inline VolumeScheduler<N>::VolumeScheduler(Sense sense, const CPXLONG * utopia) :
+    sense_(sense) {
+  for(int i = 0; i < N; ++i) {
+    utopia_[i] = utopia[i];
+  }
+}
+
+template<int N>
+inline double VolumeScheduler<N>::key(const Box<N> * b) const {
+  double volume = 1;
+  for(int i = 0; i < N; ++i) {
+    double side;
+    if (sense_ == MIN) {
+      side = static_cast<double>(b->u[i]) - utopia_[i];
+    } else {
+      side = static_cast<double>(utopia_[i]) - b->u[i];
+    }
+    volume *= std::max(side, 0.0);
+  }
+  return volume;
+}
+
+template<int N>
+inline void YieldScheduler<N>::push(Box<N> * b) {
+  size_t depth = b->depth;
+  if (depth >= queues_.size()) {
+    queues_.resize(depth + 1);
+    solved_.resize(depth + 1, 0);
+    found_.resize(depth + 1, 0);
+  }
+  queues_[depth].push_back(b);
+  size_ += 1;
+}
+
+template<int N>
+inline double YieldScheduler<N>::estimate(size_t depth) const {
+  // Laplace's rule of succession, so unexplored depths start at 1/2.
+  return (found_[depth] + 1.0) / (solved_[depth] + 2.0);
+}
+
+template<int N>
+inline Box<N> * YieldScheduler<N>::pop() {
+  size_t best = queues_.size();
+  for(size_t d = 0; d < queues_.size(); ++d) {
+    if (queues_[d].empty()) {
+      continue;
+    }
+    if ((best == queues_.size()) || (estimate(d) > estimate(best))) {
+      best = d;
+    }
+  }
+  Box<N> * b = queues_[best].front();
+  queues_[best].pop_front();
+  size_ -= 1;
+  return b;
+}
+
+template<int N>
+inline void YieldScheduler<N>::solved(const Box<N> * b, bool found) {
+  size_t depth = b->depth;
+  if (depth >= solved_.size()) {
+    return;
+  }
+  solved_[depth] += 1;
+  if (found) {
+    found_[depth] += 1;
+  }
+}
+
+template<int N>
+inline Scheduler<N> * Scheduler<N>::create(Policy policy, Sense sense,
+    const CPXLONG * utopia) {
+  switch (policy) {
+    case VOLUME:
+      return new VolumeScheduler<N>(sense, utopia);
+    case DEPTH:
+      return new DepthScheduler<N>();
+    case YIELD:
+      return new YieldScheduler<N>();
+    case FIFO:
+    default:
+      return new FifoScheduler<N>();
+  }
+}
+
+inline std::ostream & operator<<(std::ostream & str, Policy policy_) {
+  std::string res = "UNKNOWN";
+  switch (policy_) {
+    case FIFO:
+      res = "fifo";
+      break;
+    case VOLUME:
+      res = "volume";
+      break;
+    case DEPTH:
+      res = "depth";
+      break;
+    case YIELD:
+      res = "yield";
+      break;
+    default:
+      break;
+  }
+  return str << res;
+}
+
+/**
+ * Read a policy by name, as used by boost::program_options.
+ */
+inline std::istream & operator>>(std::istream & str, Policy & policy_) {
+  std::string name;
+  str >> name;
+  if (name == "fifo") {
+    policy_ = FIFO;
+  } else if (name == "volume") {
+    policy_ = VOLUME;
+  } else if (name == "depth") {
+    policy_ = DEPTH;
+  } else if (name == "yield") {
+    policy_ = YIELD;
+  } else {
+    str.setstate(std::ios_base::failbit);
+  }
+  return str;
+}
+
+#endif /* SCHEDULER_HPP */
@@ -0,0 +1,463 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include <ilcplex/cplexx.h>
+
+#include "env.hpp"
+#include "problem.hpp"
+#include "session.hpp"
+
+// How many known solutions to offer as MIP starts for a single box.
+constexpr size_t MAX_MIPSTARTS = 4;
+
+Session::Session(const Problem & master) : Solver(master) {
+  int status;
+  e.env = CPXXopenCPLEX(&status);
+  if (e.env == nullptr) {
+    std::cerr << "Failed to open CPLEX environment." << std::endl;
+    return;
+  }
+  CPXXsetintparam(e.env, CPXPARAM_Parallel, CPX_PARALLEL_DETERMINISTIC);
+  CPXXsetintparam(e.env, CPXPARAM_Threads, 1);
+  p->clone(e);
+}
+
+void Session::useUtopia() {
+  buildScalarisation();
+}
+
+void Session::setThreads(int threads) {
+  CPXXsetintparam(e.env, CPXPARAM_Threads, threads);
+}
+
+void Session::setDeterministic(bool deterministic) {
+  CPXXsetintparam(e.env, CPXPARAM_Parallel, deterministic ?
+      CPX_PARALLEL_DETERMINISTIC : CPX_PARALLEL_OPPORTUNISTIC);
+}
+
+Session::~Session() {
+  if (e.lp != nullptr) {
+    CPXXfreeprob(e.env, &e.lp);
+  }
+  if (e.env != nullptr) {
+    CPXXcloseCPLEX(&e.env);
+  }
+}
+
+void Session::buildScalarisation() {
+  // Variable numbering
+  CPXDIM cur_numcols = CPXXgetnumcols(e.env, e.lp);
+  // fi columns start at fi_index
+  fiIndex_ = cur_numcols;
+  // Add constraints for f_i variables.
+  for(int count = 0; count < objcnt_; ++count) {
+    CPXNNZ rmatbeg[1] = {0};
+    std::vector<double> rmatval;
+    std::vector<CPXDIM> rmatind;
+    // Index converts back to objective-numbering from sorted-numbering
+    int index = order_[count];
+    for(int k = 0; k < p->objnzcnt[index]; ++k) {
+      if (p->objcoef[index][k] != 0) {
+        rmatind.push_back(p->objind[index][k]);
+        rmatval.push_back(p->objcoef[index][k]);
+      }
+    }
+    // New variable for f_i
+    rmatval.push_back(-1);
+    rmatind.push_back(cur_numcols);
+    double rhs[1] = {0};
+    char sense[1] = {'E'};
+    char name[] = "f_X";
+    name[2] = '0' + count;
+    char * names[1] = {name};
+    CPXXaddrows(e.env, e.lp, 1 /* one new columns */, 1 /* one new row */,
+                rmatval.size(), // Number of non-zeros
+                rhs, sense, rmatbeg, rmatind.data(), rmatval.data(),
+                names, // new column name
+                nullptr); // new row name
+    cur_numcols += 1;
+  }
+
+  // Add constraints for diff_i variables. The coefficients and right-hand
+  // sides of these rows are filled in by setWeights().
+  diffiIndex_ = cur_numcols;
+  diffiRow_ = CPXXgetnumrows(e.env, e.lp);
+  for(int count = 0; count < objcnt_; ++count) {
+    CPXNNZ rmatbeg[1] = {0};
+    double rmatval[2];
+    CPXDIM rmatind[2];
+    rmatind[0] = fiIndex_ + count;
+    rmatval[0] = 1;
+    rmatind[1] = cur_numcols;
+    cur_numcols += 1;
+    rmatval[1] = -1;
+    char name[] = "diffiX";
+    name[5] = '0' + count;
+    char * names[1] = {name};
+    double rhs[1] = {0};
+    if (sense_ == MAX) {
+      rmatval[1] *= -1;
+    }
+    char sense[1] = {'E'};
+    CPXXaddrows(e.env, e.lp, 1 /* one new columns */, 1 /* one new row */,
+                2, // Number of non-zeros
+                rhs, sense, rmatbeg, rmatind, rmatval,
+                names, // new column name
+                nullptr); // new row name
+  }
+  // Add mdiff variable
+  char name[] = "max_diff";
+  char * names[] = {name};
+  CPXXaddcols(e.env, e.lp, 1 /* one new column */, 0 /* no non-zero */,
+    nullptr /* no objective change */, nullptr /* cmatbeg */, nullptr /* cmatind */,
+    nullptr /* cmatend */, nullptr /* lb */, nullptr /* ub */, names /* name */);
+  CPXDIM mdiff_index = cur_numcols;
+  cur_numcols += 1;
+  // and constraints for it.
+  for(int count = 0; count < objcnt_; ++count) {
+    CPXNNZ rmatbeg[1] = {0};
+    double rmatval[2];
+    CPXDIM rmatind[2];
+    rmatind[0] = diffiIndex_ + count;
+    rmatval[0] = 1;
+    rmatind[1] = mdiff_index;
+    rmatval[1] = -1;
+    double rhs[1] = {0};
+    char sense[1] = {'L'};
+    CPXXaddrows(e.env, e.lp, 0 /* no new columns */, 1 /* one new row */,
+                2, // Number of non-zeros
+                rhs, sense, rmatbeg, rmatind, rmatval,
+                nullptr, // new column name
+                nullptr); // new row name
+  }
+
+  // Add a row bounding the sum of the f_i. This is only tightened while
+  // verifying a point, otherwise it is inactive.
+  {
+    sumRow_ = CPXXgetnumrows(e.env, e.lp);
+    CPXNNZ rmatbeg[1] = {0};
+    double rmatval[objcnt_];
+    CPXDIM rmatind[objcnt_];
+    for(int count = 0; count < objcnt_; ++count) {
+      rmatind[count] = fiIndex_ + count;
+      rmatval[count] = 1;
+    }
+    double rhs[1];
+    char sense[1];
+    if (sense_ == MIN) {
+      rhs[0] = CPX_INFBOUND;
+      sense[0] = 'L';
+    } else {
+      rhs[0] = -CPX_INFBOUND;
+      sense[0] = 'G';
+    }
+    CPXXaddrows(e.env, e.lp, 0 /* no new columns */, 1 /* one new row */,
+                objcnt_, // Number of non-zeros
+                rhs, sense, rmatbeg, rmatind, rmatval,
+                nullptr, // new column name
+                nullptr); // new row name
+  }
+
+  // Set new objective into something
+  // obj = mdiff + rho*f_i - rho*u_i      MINIMIZE
+  // obj = mdiff + rho*u_i - rho*f_i      MAXIMIZE
+  // Seeing as u_i and rho are constants we ignore them in the objective.
+  // Don't forget that CPLEX doesn't "set" the objective function, it just
+  // changes objective coefficients by index. If we don't refer to all possible
+  // variables, we might have other variables in our objective (from e.g. when
+  // we read in the problem). This is only done once per session; the f_i
+  // coefficients are set by setWeights().
+  {
+    std::vector<double> objcoef(cur_numcols, 0);
+    std::vector<CPXDIM> indices(cur_numcols);
+    for(CPXDIM count = 0; count < cur_numcols; ++count) {
+      indices[count] = count;
+    }
+    objcoef[mdiff_index] = 1;
+    CPXXchgobj(e.env, e.lp, cur_numcols, indices.data(), objcoef.data());
+  }
+
+  // Set CPLEX problem sense to minimise. We always want to minimise the
+  // difference.
+  CPXXchgobjsen(e.env, e.lp, CPX_MIN);
+
+  setWeights(weights_.data(), rho_);
+}
+
+void Session::setWeights(const double weights[], double rho) {
+  if (weights != weights_.data()) {
+    weights_.assign(weights, weights + objcnt_);
+  }
+  rho_ = rho;
+  for(int count = 0; count < objcnt_; ++count) {
+    CPXXchgcoef(e.env, e.lp, diffiRow_ + count, fiIndex_ + count,
+                weights[count]);
+  }
+  CPXDIM rows[objcnt_];
+  CPXDIM cols[objcnt_];
+  double rhs[objcnt_];
+  double objcoef[objcnt_];
+  for(int count = 0; count < objcnt_; ++count) {
+    rows[count] = diffiRow_ + count;
+    cols[count] = fiIndex_ + count;
+    rhs[count] = weights[count] * sortedUtopia_[count];
+    if (sense_ == MIN) {
+      objcoef[count] = rho;
+    } else {
+      objcoef[count] = -rho;
+    }
+  }
+  CPXXchgrhs(e.env, e.lp, objcnt_, rows, rhs);
+  CPXXchgobj(e.env, e.lp, objcnt_, cols, objcoef);
+}
+
+void Session::setBox(const CPXLONG u[]) {
+  CPXDIM indices[objcnt_];
+  char lu[objcnt_];
+  double bd[objcnt_];
+  for(int count = 0; count < objcnt_; ++count) {
+    indices[count] = fiIndex_ + count;
+    // Index converts back to objective-numbering from sorted-numbering
+    int index = order_[count];
+    // We subtract 0.5 from the upper bound as the bound is meant to be <,
+    // but CPLEX only does ≤
+    if (sense_ == MIN) {
+      lu[count] = 'U';
+      bd[count] = static_cast<double>(u[index]) - 0.5;
+    } else {
+      // Same for a lower bound. The f_i columns are created with a lower
+      // bound of 0, which we keep.
+      lu[count] = 'L';
+      bd[count] = std::max(0.0, static_cast<double>(u[index]) + 0.5);
+    }
+  }
+  CPXXchgbds(e.env, e.lp, objcnt_, indices, lu, bd);
+}
+
+void Session::watch(volatile int * abort) {
+  CPXXsetterminate(e.env, abort);
+}
+
+int Session::warmStart(const std::vector<KnownPoint> & known) {
+  CPXDIM num_variables = fiIndex_;
+  std::vector<std::pair<double, const KnownPoint *>> starts;
+  for(auto & r: known) {
+    if (static_cast<CPXDIM>(r.x->size()) != num_variables) {
+      continue;
+    }
+    starts.emplace_back(scalarise(r.soln), &r);
+  }
+  if (starts.empty()) {
+    return 0;
+  }
+  std::sort(starts.begin(), starts.end(),
+      [](const std::pair<double, const KnownPoint *> &a,
+         const std::pair<double, const KnownPoint *> &b) {
+        return a.first < b.first;
+      });
+  if (starts.size() > MAX_MIPSTARTS) {
+    starts.resize(MAX_MIPSTARTS);
+  }
+
+  // The objective columns are left out: CPLEX solves for them once the
+  // problem's own variables are fixed. The known points lie outside the box
+  // (see Solver::warmStart()), so CPLEX must repair each start before it can
+  // use it.
+  std::vector<CPXNNZ> beg;
+  std::vector<CPXDIM> varindices;
+  std::vector<double> values;
+  std::vector<int> effortlevel;
+  for(auto & s: starts) {
+    beg.push_back(values.size());
+    for(CPXDIM i = 0; i < num_variables; ++i) {
+      varindices.push_back(i);
+      values.push_back((*s.second->x)[i]);
+    }
+    effortlevel.push_back(CPX_MIPSTART_REPAIR);
+  }
+  int status = CPXXaddmipstarts(e.env, e.lp, beg.size(), values.size(),
+                                beg.data(), varindices.data(), values.data(),
+                                effortlevel.data(), nullptr);
+  if (status) {
+    std::cerr << "Failed to add MIP starts." << std::endl;
+    return 0;
+  }
+  return CPXXgetnummipstarts(e.env, e.lp);
+}
+
+bool Session::verify(const CPXLONG soln[]) {
+  reset();
+  // Look for any point y with y <= soln and sum(y) < sum(soln) (or the
+  // reverse when maximising). As objective values are integral, the strict
+  // inequality becomes a bound of sum(soln) - 1.
+  CPXDIM indices[objcnt_];
+  char lu[objcnt_];
+  double bd[objcnt_];
+  double sum = 0;
+  for(int count = 0; count < objcnt_; ++count) {
+    indices[count] = fiIndex_ + count;
+    double value = static_cast<double>(soln[order_[count]]);
+    sum += value;
+    if (sense_ == MIN) {
+      lu[count] = 'U';
+      bd[count] = value;
+    } else {
+      lu[count] = 'L';
+      bd[count] = std::max(0.0, value);
+    }
+  }
+  CPXXchgbds(e.env, e.lp, objcnt_, indices, lu, bd);
+  double rhs = (sense_ == MIN) ? sum - 1 : sum + 1;
+  CPXXchgrhs(e.env, e.lp, 1, &sumRow_, &rhs);
+  // Any feasible solution answers the question, so stop at the first.
+  CPXXsetlongparam(e.env, CPXPARAM_MIP_Limits_Solutions, 1);
+
+  int status = CPXXmipopt(e.env, e.lp);
+  bool nondominated = false;
+  if (status == 0) {
+    status = CPXXgetstat(e.env, e.lp);
+    nondominated = (status == CPXMIP_INFEASIBLE) ||
+                   (status == CPXMIP_INForUNBD);
+  } else {
+    std::cerr << "Failed to optimize LP." << std::endl;
+  }
+
+  CPXXsetlongparam(e.env, CPXPARAM_MIP_Limits_Solutions,
+                   9223372036800000000LL);
+  rhs = (sense_ == MIN) ? CPX_INFBOUND : -CPX_INFBOUND;
+  CPXXchgrhs(e.env, e.lp, 1, &sumRow_, &rhs);
+  reset();
+  return nondominated;
+}
+
+void Session::reset() {
+  CPXDIM indices[objcnt_];
+  char lu[objcnt_];
+  double bd[objcnt_];
+  for(int count = 0; count < objcnt_; ++count) {
+    indices[count] = fiIndex_ + count;
+    if (sense_ == MIN) {
+      lu[count] = 'U';
+      bd[count] = CPX_INFBOUND;
+    } else {
+      lu[count] = 'L';
+      bd[count] = 0;
+    }
+  }
+  CPXXchgbds(e.env, e.lp, objcnt_, indices, lu, bd);
+  // CPLEX also keeps the incumbent of the last solve as a MIP start, so we
+  // always clear these, not just when warmStart() added some.
+  int mipstarts = CPXXgetnummipstarts(e.env, e.lp);
+  if (mipstarts > 0) {
+    CPXXdelmipstarts(e.env, e.lp, 0, mipstarts - 1);
+  }
+  int poolsize = CPXXgetsolnpoolnumsolns(e.env, e.lp);
+  if (poolsize > 0) {
+    CPXXdelsolnpoolsolns(e.env, e.lp, 0, poolsize - 1);
+  }
+}
+
+SolveStatus Session::solve(CPXLONG soln[], std::vector<double> * x) {
+  int status = CPXXmipopt(e.env, e.lp);
+  if (status != 0) {
+    std::cerr << "Failed to optimize LP." << std::endl;
+  }
+  status = CPXXgetstat(e.env, e.lp);
+  if ((status == CPXMIP_ABORT_FEAS) || (status == CPXMIP_ABORT_INFEAS)) {
+    return SOLVE_ABORTED;
+  }
+  if ((status == CPXMIP_INFEASIBLE) || (status == CPXMIP_INForUNBD)) {
+    return SOLVE_INFEASIBLE;
+  }
+  if (! readObjectives(-1, soln)) {
+    std::cerr << "Failed to obtain objective value." << std::endl;
+    return SOLVE_FAILED;
+  }
+  if (x != nullptr) {
+    x->resize(fiIndex_);
+    if (CPXXgetx(e.env, e.lp, x->data(), 0, fiIndex_-1) != 0) {
+      std::cerr << "Failed to obtain solution." << std::endl;
+      x->clear();
+    }
+  }
+  return SOLVE_OPTIMAL;
+}
+
+bool Session::readObjectives(int n, CPXLONG soln[]) {
+  double objval[objcnt_];
+  int status;
+  if (n < 0) {
+    status = CPXXgetx(e.env, e.lp, objval, fiIndex_, fiIndex_+objcnt_-1);
+  } else {
+    status = CPXXgetsolnpoolx(e.env, e.lp, n, objval, fiIndex_,
+                              fiIndex_+objcnt_-1);
+  }
+  if (status != 0) {
+    return false;
+  }
+  // The f_i columns are in sorted order, so put each value back in the
+  // position of its original objective.
+  for(int count = 0; count < objcnt_; ++count) {
+    soln[order_[count]] = std::lround(objval[count]);
+  }
+  return true;
+}
+
+int Session::poolSize() {
+  return CPXXgetsolnpoolnumsolns(e.env, e.lp);
+}
+
+bool Session::poolPoint(int n, CPXLONG soln[], std::vector<double> * x) {
+  if (! readObjectives(n, soln)) {
+    return false;
+  }
+  if (x != nullptr) {
+    x->resize(fiIndex_);
+    if (CPXXgetsolnpoolx(e.env, e.lp, n, x->data(), 0, fiIndex_-1) != 0) {
+      x->clear();
+    }
+  }
+  return true;
+}
+
+int Session::bestValue(int i, CPXLONG & value) {
+  // Objective i is sparse, but every other coefficient must become 0.
+  CPXDIM cur_numcols = CPXXgetnumcols(e.env, e.lp);
+  std::vector<CPXDIM> indices(cur_numcols);
+  std::vector<double> coef(cur_numcols, 0);
+  for(CPXDIM j = 0; j < cur_numcols; ++j) {
+    indices[j] = j;
+  }
+  for(int k = 0; k < p->objnzcnt[i]; ++k) {
+    coef[p->objind[i][k]] = p->objcoef[i][k];
+  }
+  int status = CPXXchgobj(e.env, e.lp, cur_numcols, indices.data(),
+                          coef.data());
+  if ( status ) {
+    std::cerr << "Failed to change objective function." << std::endl;
+  }
+  status = CPXXmipopt (e.env, e.lp);
+  if ( status ) {
+    std::cerr << "Failed to obtain objective value." << std::endl;
+  }
+  double val;
+  status = CPXXgetobjval(e.env, e.lp, &val);
+  value = round(val);
+  return status;
+}
@@ -0,0 +1,126 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+#ifndef SESSION_HPP
+#define SESSION_HPP
+
+#include <vector>
+
+#include <ilcplex/cplexx.h>
+
+#include "env.hpp"
+#include "problem.hpp"
+#include "sense.hpp"
+#include "solver.hpp"
+
+/**
+ * A long-lived CPLEX session, owned by a single worker thread. The CPLEX
+ * environment is opened and the problem cloned from the master problem once,
+ * and then reused for every box the worker solves.
+ *
+ * When the utopia point is set, the augmented Chebyshev scalarisation is
+ * added to the model once: an f_i column and row for each objective, a diff_i
+ * column and row for each objective, the max_diff column with its rows, and
+ * an (inactive) row on the sum of the f_i.
+ * Solving a box then only changes the bounds on the f_i columns (see setBox),
+ * and reset() removes them again.
+ */
+class Session : public Solver {
+  public:
+    /**
+     * Open a CPLEX environment holding a copy of master.
+     */
+    explicit Session(const Problem & master);
+    ~Session();
+
+    /**
+     * Optimises objective i alone, with the problem's own sense.
+     */
+    int bestValue(int i, CPXLONG & value) override;
+
+    void setThreads(int threads) override;
+
+    void setDeterministic(bool deterministic) override;
+
+    /**
+     * Set the scalarisation weights. weights[i] applies to the i'th objective
+     * in sorted order (see objective()), and rho to the augmentation term.
+     */
+    void setWeights(const double weights[], double rho);
+
+    void setBox(const CPXLONG u[]) override;
+
+    /**
+     * Known solutions, usually the points bordering the box from
+     * Archive::bordering(), are offered to CPLEX as CPX_MIPSTART_REPAIR
+     * starts. No objective cutoff is set.
+     */
+    int warmStart(const std::vector<KnownPoint> & known) override;
+    using Solver::warmStart;
+
+    /**
+     * CPLEX polls *abort while solving (see CPXXsetterminate).
+     */
+    void watch(volatile int * abort) override;
+
+    SolveStatus solve(CPXLONG soln[], std::vector<double> * x) override;
+
+    /**
+     * The CPLEX solution pool.
+     */
+    int poolSize() override;
+    bool poolPoint(int n, CPXLONG soln[], std::vector<double> * x) override;
+
+    /**
+     * Solves a feasibility problem over the region soln dominates.
+     */
+    bool verify(const CPXLONG soln[]) override;
+
+    /**
+     * Also drops any MIP starts, lifts the box bounds on the f_i columns and
+     * clears the solution pool.
+     */
+    void reset() override;
+
+    /**
+     * Index of the first f_i column. The f_i columns are stored in sorted
+     * objective order.
+     */
+    CPXDIM fiIndex() const;
+
+    Env e;
+
+  protected:
+    void useUtopia() override;
+
+  private:
+    void buildScalarisation();
+
+    /**
+     * Read the f_i columns of solution n of the pool (or the incumbent if n
+     * is -1) into soln, in the objectives' own order.
+     */
+    bool readObjectives(int n, CPXLONG soln[]);
+
+    CPXDIM fiIndex_;
+    CPXDIM diffiIndex_;
+    CPXDIM diffiRow_;
+    // Row bounding the sum of the f_i, only used by verify().
+    CPXDIM sumRow_;
+};
+
+inline CPXDIM Session::fiIndex() const {
+  return fiIndex_;
+}
+
+#endif /* SESSION_HPP */
@@ -0,0 +1,185 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <ilcplex/cplexx.h>
+
+#include "enumerator.hpp"
+#include "problem.hpp"
+#include "session.hpp"
+#include "solver.hpp"
+
+Solver::Solver(const Problem & master) : p(&master),
+    objcnt_(master.objcnt), sense_(master.objsen), rho_(0) {
+}
+
+void Solver::setUtopia(const CPXLONG * utopia) {
+  float eta = 0.01;
+
+  // Create a pair <int, float> for each objective function.
+  // This way we can track and "undo" a sort.
+  std::vector<std::pair<int, float>> obj_utop;
+  for(int count = 0; count < objcnt_; ++count) {
+    obj_utop.emplace_back(count, utopia[count]);
+  }
+
+  if (sense_ == MIN) {
+    std::sort(obj_utop.begin(), obj_utop.end(),
+        [](const std::pair<int, float> &a, const std::pair<int, float> &b) {
+          return a.second < b.second;
+        });
+  } else {
+    std::sort(obj_utop.begin(), obj_utop.end(),
+        [](const std::pair<int, float> &a, const std::pair<int, float> &b) {
+          return a.second > b.second;
+        });
+  }
+
+  float sorted_utopia[objcnt_];
+
+  order_.clear();
+  sortedUtopia_.clear();
+  weights_.clear();
+  for(int count = 0; count < objcnt_; ++count) {
+    sorted_utopia[count] = obj_utop[count].second;
+    order_.push_back(obj_utop[count].first);
+    sortedUtopia_.push_back(sorted_utopia[count]);
+  }
+
+  float u_tilde[objcnt_];
+  float u_eta[objcnt_];
+  float sigma = 0;
+  float cap_u = 0;
+  for(int i = 0; i < objcnt_; ++i) {
+    u_tilde[i] = sorted_utopia[i];
+    sigma += u_tilde[i];
+    if (sense_ == MIN) {
+      u_eta[i] = sorted_utopia[i] - eta;
+    } else {
+      u_eta[i] = sorted_utopia[i] + eta;
+    }
+    cap_u += 1 / u_eta[i];
+  }
+
+  float denom = u_eta[0] * cap_u * (sigma - u_tilde[0]) - objcnt_*(1 - eta);
+
+  for(int i = 0; i < objcnt_; ++i) {
+    weights_.push_back((u_eta[0] * (sigma - u_tilde[0]) - u_eta[i] * (1 - eta)) / (u_eta[i] * denom));
+  }
+
+  float rho = (1 - eta) / denom;
+  rho_ = rho;
+  useUtopia();
+}
+
+double Solver::scalarise(const CPXLONG soln[]) const {
+  // This mirrors the model: diff_i = w_i (f_i - u_i) when minimising and
+  // w_i (u_i - f_i) when maximising, and max_diff is at least every diff_i
+  // and at least 0 (its lower bound).
+  double max_diff = 0;
+  double sum = 0;
+  for(int count = 0; count < objcnt_; ++count) {
+    double f = static_cast<double>(soln[order_[count]]);
+    double diff = weights_[count] * (f - sortedUtopia_[count]);
+    if (sense_ == MAX) {
+      diff = -diff;
+    }
+    max_diff = std::max(max_diff, diff);
+    sum += f;
+  }
+  if (sense_ == MIN) {
+    return max_diff + rho_ * sum;
+  }
+  return max_diff - rho_ * sum;
+}
+
+Solver * Solver::create(Backend backend, const Problem & master) {
+  switch (backend) {
+    case ENUMERATE:
+      return new Enumerator(master);
+    case CPLEX:
+    default:
+      return new Session(master);
+  }
+}
+
+Solver * Solver::create(Backend backend, const Problem & master,
+    const CPXLONG * utopia) {
+  Solver * solver = create(backend, master);
+  solver->setUtopia(utopia);
+  return solver;
+}
+
+bool Solver::open(Backend backend, const Problem & master, size_t count,
+    CPXLONG * utopia, std::vector<Solver *> & solvers) {
+  size_t objcnt = master.objcnt;
+  // Finding the utopia point needs at least one solver, and can keep at
+  // most one per objective busy.
+  size_t opened = std::max(count, static_cast<size_t>(utopia != nullptr));
+  size_t finders = (utopia == nullptr) ? 0 : std::min(opened, objcnt);
+  solvers.assign(opened, nullptr);
+  std::atomic<int> failures(0);
+  std::vector<std::thread> threads;
+  for(size_t t = 0; t < opened; ++t) {
+    threads.emplace_back([&, t] {
+        solvers[t] = create(backend, master);
+        if (t >= finders) {
+          return;
+        }
+        // The solvers that find the utopia point share out the threads
+        // between them, and take turns at the objectives.
+        size_t share = std::max(opened / finders +
+            ((t < opened % finders) ? 1 : 0), static_cast<size_t>(1));
+        solvers[t]->setThreads(share);
+        for(size_t i = t; i < objcnt; i += finders) {
+          if (solvers[t]->bestValue(i, utopia[i]) != 0) {
+            failures += 1;
+          }
+        }
+        solvers[t]->setThreads(1);
+      });
+  }
+  for(auto & thread: threads) {
+    thread.join();
+  }
+  if (failures > 0) {
+    for(auto solver: solvers) {
+      delete solver;
+    }
+    solvers.clear();
+    return false;
+  }
+  // The solver opened only to find the utopia point isn't wanted.
+  for(size_t t = count; t < opened; ++t) {
+    delete solvers[t];
+  }
+  solvers.resize(count);
+  return true;
+}
+
+bool Solver::canSolve(Backend backend, const Problem & p) {
+  switch (backend) {
+    case ENUMERATE:
+      return Enumerator::canSolve(p);
+    case CPLEX:
+    default:
+      return true;
+  }
+}
@@ -0,0 +1,263 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+
+#ifndef SOLVER_HPP
+#define SOLVER_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <ilcplex/cplexx.h>
+
+#include "problem.hpp"
+#include "sense.hpp"
+
+template<int N> class Result;
+
+/**
+ * Which solver finds points in boxes:
+ * CPLEX - CPLEX's MIP solver
+ * ENUMERATE - a simple branch and bound in this process, for small pure
+ *             integer problems with bounded variables
+ */
+enum Backend { CPLEX, ENUMERATE };
+
+/**
+ * A known point, offered to warmStart().
+ */
+struct KnownPoint {
+  const CPXLONG * soln;
+  // The values of the problem's own variables at this point.
+  const std::vector<double> * x;
+};
+
+/**
+ * How a solve ended.
+ */
+enum SolveStatus {
+  SOLVE_OPTIMAL,    // The optimum of the scalarisation in the box was found.
+  SOLVE_INFEASIBLE, // The box holds no point.
+  SOLVE_ABORTED,    // The watched abort flag was set before the solve ended.
+  SOLVE_FAILED      // The solver failed.
+};
+
+/**
+ * A long-lived solver for one worker thread, which repeatedly finds the
+ * point in a box that minimises the augmented Chebyshev scalarisation of the
+ * problem, or shows that there is none.
+ *
+ * A solver is first opened on the master problem, when it can find the best
+ * value of each objective on its own (see bestValue()). The scalarisation is
+ * then fixed by setUtopia(): its weights come from the utopia point, and
+ * every objective is handled in sorted order of its utopia value (see
+ * objective()). Everything else needs the scalarisation.
+ */
+class Solver {
+  public:
+    explicit Solver(const Problem & master);
+    virtual ~Solver() { }
+
+    /**
+     * Find the best value of objective i on its own. Only valid before
+     * setUtopia(). Returns nonzero on failure.
+     */
+    virtual int bestValue(int i, CPXLONG & value) = 0;
+
+    /**
+     * Use up to threads threads for each solve.
+     */
+    virtual void setThreads(int /* threads */) { }
+
+    /**
+     * Whether a solve with more than one thread must take the same path, and
+     * so give the same answer, every time. This is the default; otherwise the
+     * threads may share work as they go, which is usually faster.
+     */
+    virtual void setDeterministic(bool /* deterministic */) { }
+
+    /**
+     * Build the scalarisation for the given utopia point.
+     */
+    void setUtopia(const CPXLONG * utopia);
+
+    /**
+     * Whether setUtopia() has been called.
+     */
+    bool hasUtopia() const;
+
+    /**
+     * Restrict the objective values to lie strictly inside the box with
+     * upper corner u (lower corner when maximising).
+     */
+    virtual void setBox(const CPXLONG u[]) = 0;
+
+    /**
+     * Offer known solutions as starting points. No known point lies strictly
+     * inside the current box, as the box would have been split, so these
+     * are usually just outside it, and the solver may try to repair them
+     * into the box. Solutions without a decision vector are ignored.
+     * Returns how many starts the solver took.
+     */
+    virtual int warmStart(const std::vector<KnownPoint> & known) = 0;
+
+    template<int N>
+    int warmStart(const std::vector<Result<N> *> & known);
+
+    /**
+     * Abort any solve as soon as *abort becomes nonzero. Pass nullptr to stop
+     * watching. This is not changed by reset().
+     */
+    virtual void watch(volatile int * abort) = 0;
+
+    /**
+     * Minimise the scalarisation inside the current box. On SOLVE_OPTIMAL,
+     * soln holds the objective values of the optimum, and x (if not nullptr)
+     * the values of the problem's own variables.
+     */
+    virtual SolveStatus solve(CPXLONG soln[], std::vector<double> * x) = 0;
+
+    /**
+     * The number of other feasible points kept from the last solve, which
+     * can be read with poolPoint().
+     */
+    virtual int poolSize() { return 0; }
+
+    /**
+     * The objective values of the n'th point kept from the last solve, and
+     * its decision vector if x is not nullptr. Returns false on failure.
+     */
+    virtual bool poolPoint(int /* n */, CPXLONG /* soln */[],
+        std::vector<double> * /* x */) {
+      return false;
+    }
+
+    /**
+     * Check whether any feasible point dominates soln. Returns true if soln
+     * is proven to be nondominated. This discards the last solution and any
+     * starting points.
+     */
+    virtual bool verify(const CPXLONG soln[]) = 0;
+
+    /**
+     * Remove any box-specific state, leaving the scalarisation unbounded and
+     * dropping any starting points.
+     */
+    virtual void reset() = 0;
+
+    /**
+     * The value of the scalarisation at a point with objective values soln.
+     */
+    double scalarise(const CPXLONG soln[]) const;
+
+    /**
+     * Index of the objective that is i'th in sorted order.
+     */
+    int objective(int i) const;
+
+    /**
+     * Whether the given kind of solver can solve p. If not, says why on
+     * std::cerr.
+     */
+    static bool canSolve(Backend backend, const Problem & p);
+
+    /**
+     * Open a solver of the given kind on master, which it must be able to
+     * solve (see canSolve()).
+     */
+    static Solver * create(Backend backend, const Problem & master);
+
+    /**
+     * Open a solver and set its utopia point.
+     */
+    static Solver * create(Backend backend, const Problem & master,
+        const CPXLONG * utopia);
+
+    /**
+     * Open count solvers at once, each in its own thread. If utopia is not
+     * nullptr, also find the utopia point with them: each objective is
+     * solved on a different solver at the same time, with the threads split
+     * between those solves, while the remaining solvers are opened. The
+     * solvers are put in solvers without a utopia point set. Returns false,
+     * with no solvers open, if finding the utopia point failed.
+     */
+    static bool open(Backend backend, const Problem & master, size_t count,
+        CPXLONG * utopia, std::vector<Solver *> & solvers);
+
+    // The master problem, shared read-only between all solvers.
+    const Problem * p;
+
+  protected:
+    /**
+     * Build the scalarisation, once the weights are known.
+     */
+    virtual void useUtopia() = 0;
+
+    int objcnt_;
+    Sense sense_;
+    // order_[i] is the objective that is i'th when sorted by utopia value.
+    std::vector<int> order_;
+    std::vector<double> sortedUtopia_;
+    // weights_[i] applies to the i'th objective in sorted order, and rho_ to
+    // the augmentation term.
+    std::vector<double> weights_;
+    double rho_;
+};
+
+template<int N>
+inline int Solver::warmStart(const std::vector<Result<N> *> & known) {
+  std::vector<KnownPoint> points;
+  points.reserve(known.size());
+  for(auto r: known) {
+    points.push_back(KnownPoint{r->soln, &r->x});
+  }
+  return warmStart(points);
+}
+
+inline bool Solver::hasUtopia() const {
+  return ! order_.empty();
+}
+
+inline int Solver::objective(int i) const {
+  return order_[i];
+}
+
+inline std::ostream & operator<<(std::ostream & str, Backend backend_) {
+  switch (backend_) {
+    case CPLEX:
+      return str << "cplex";
+    case ENUMERATE:
+      return str << "enumerate";
+    default:
+      return str << "UNKNOWN";
+  }
+}
+
+/**
+ * Read a backend by name, as used by boost::program_options.
+ */
+inline std::istream & operator>>(std::istream & str, Backend & backend_) {
+  std::string name;
+  str >> name;
+  if (name == "cplex") {
+    backend_ = CPLEX;
+  } else if (name == "enumerate") {
+    backend_ = ENUMERATE;
+  } else {
+    str.setstate(std::ios_base::failbit);
+  }
+  return str;
+}
+
+#endif /* SOLVER_HPP */
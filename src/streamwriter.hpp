@@ -0,0 +1,114 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+#ifndef STREAMWRITER_HPP
+#define STREAMWRITER_HPP
+
+#include <condition_variable>
+#include <ctime>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <ilcplex/cplexx.h>
+
+/**
+ * Appends points to a file as they are found, so that a long run has usable
+ * output before it finishes. Each line holds the elapsed wall-clock time,
+ * the number of IPs solved so far, and then the objective values, separated
+ * by tabs.
+ *
+ * write() only formats the line and queues it; a background thread does the
+ * file I/O, and flushes after each batch so that readers of the file see
+ * every point soon after it is found.
+ */
+class StreamWriter {
+  public:
+    /**
+     * start is the time the run started, as seconds on CLOCK_MONOTONIC.
+     */
+    StreamWriter(const std::string & filename, double start);
+    ~StreamWriter();
+
+    bool good() const;
+
+    void write(const CPXLONG p[], int objcnt, int ips);
+
+  private:
+    void run();
+
+    std::ofstream out_;
+    double start_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::string pending_;
+    bool stop_;
+    std::thread thread_;
+};
+
+inline StreamWriter::StreamWriter(const std::string & filename, double start) :
+    out_(filename), start_(start), stop_(false) {
+  out_ << "# elapsed seconds\tIPs solved\tobjective values" << std::endl;
+  thread_ = std::thread(&StreamWriter::run, this);
+}
+
+inline StreamWriter::~StreamWriter() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  condition_.notify_one();
+  thread_.join();
+}
+
+inline bool StreamWriter::good() const {
+  return out_.good();
+}
+
+inline void StreamWriter::write(const CPXLONG p[], int objcnt, int ips) {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  std::stringstream line;
+  line << (now.tv_sec + now.tv_nsec/1e9 - start_) << "\t" << ips;
+  for(int i = 0; i < objcnt; ++i) {
+    line << "\t" << p[i];
+  }
+  line << "\n";
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    pending_ += line.str();
+  }
+  condition_.notify_one();
+}
+
+inline void StreamWriter::run() {
+  std::string batch;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this]{ return stop_ || !pending_.empty(); });
+      if (pending_.empty()) {
+        // stop_ is set and everything is written.
+        return;
+      }
+      batch.swap(pending_);
+    }
+    out_ << batch;
+    out_.flush();
+    batch.clear();
+  }
+}
+
+#endif /* STREAMWRITER_HPP */
@@ -26,8 +26,6 @@ You should have received a copy of the GNU General Public License along with thi
 extern std::mutex debug_mutex;
 #endif
 
-class Result;
-
 /**
  * Status of a task:
  * WAITING - waiting for pre-requisites to complete
@@ -45,8 +43,6 @@ class Task {
     Status status() const;
     int objCount() const;
 
-    virtual Result * operator()() = 0;
-
     virtual std::string str() const = 0;
     virtual std::string details() const = 0;
 
@@ -0,0 +1,148 @@
+/*
+
+boxsplit - an implementation of a multi-criteria optimisation algorithm of Klamroth and Dächert
+Copyright (C) 2017 William Pettersson <william.pettersson@gmail.com>
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation; either version 2 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with this program; if not, write to the Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+*/
+
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <ilcplex/cplexx.h>
+
+typedef std::chrono::steady_clock TraceClock;
+
+/**
+ * The events recorded by one thread. Only that thread may add to it, so
+ * recording takes no locks.
+ */
+class TraceBuffer {
+  public:
+    TraceBuffer(int tid, const std::string & name) : tid_(tid), name_(name) { }
+
+    /**
+     * Record that the thread spent from start to end on name. args, if
+     * given, is the inside of a JSON object, e.g. "\"outcome\":\"point\"".
+     */
+    void complete(const char * name, TraceClock::time_point start,
+        TraceClock::time_point end, const std::string & args = "");
+
+  private:
+    friend class Trace;
+
+    struct Event {
+      const char * name;
+      TraceClock::time_point start;
+      TraceClock::time_point end;
+      std::string args;
+    };
+
+    int tid_;
+    std::string name_;
+    std::vector<Event> events_;
+};
+
+/**
+ * Records what each thread spends its time on, and writes it as a Chrome
+ * trace-event JSON file, which can be opened in Perfetto or chrome://tracing.
+ * Each thread gets its own TraceBuffer, and the file is only written when the
+ * Trace is destroyed, so nothing is written while the run is going.
+ */
+class Trace {
+  public:
+    explicit Trace(const std::string & filename);
+    ~Trace();
+
+    bool good() const;
+
+    /**
+     * A new buffer for the calling thread, shown as name in the trace. The
+     * buffer lives as long as the Trace.
+     */
+    TraceBuffer * thread(const std::string & name);
+
+  private:
+    std::ofstream out_;
+    TraceClock::time_point start_;
+    std::mutex mutex_;
+    std::list<TraceBuffer> buffers_;
+};
+
+/**
+ * Trace arguments for a box with upper corner u, and what came of it: one
+ * of "point", "infeasible" or "obsolete" (split before it was solved).
+ */
+inline std::string traceArgs(const CPXLONG u[], int objcnt,
+    const char * outcome) {
+  std::stringstream ss;
+  ss << "\"u\":[" << u[0];
+  for(int i = 1; i < objcnt; ++i) {
+    ss << "," << u[i];
+  }
+  ss << "],\"outcome\":\"" << outcome << "\"";
+  return ss.str();
+}
+
+inline void TraceBuffer::complete(const char * name,
+    TraceClock::time_point start, TraceClock::time_point end,
+    const std::string & args) {
+  events_.push_back(Event{name, start, end, args});
+}
+
+inline Trace::Trace(const std::string & filename) : out_(filename),
+    start_(TraceClock::now()) {
+}
+
+inline bool Trace::good() const {
+  return out_.good();
+}
+
+inline TraceBuffer * Trace::thread(const std::string & name) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  buffers_.emplace_back(buffers_.size() + 1, name);
+  return &buffers_.back();
+}
+
+inline Trace::~Trace() {
+  // Timestamps are in microseconds since the Trace was created.
+  auto micros = [this](TraceClock::time_point t) {
+    return std::chrono::duration<double, std::micro>(t - start_).count();
+  };
+  out_ << std::fixed << std::setprecision(3);
+  out_ << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  for(auto & buffer: buffers_) {
+    out_ << (first ? "\n" : ",\n");
+    first = false;
+    out_ << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+      << buffer.tid_ << ",\"args\":{\"name\":\"" << buffer.name_ << "\"}}";
+    for(auto & event: buffer.events_) {
+      out_ << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,"
+        << "\"tid\":" << buffer.tid_ << ",\"ts\":" << micros(event.start)
+        << ",\"dur\":" << micros(event.end) - micros(event.start);
+      if (! event.args.empty()) {
+        out_ << ",\"args\":{" << event.args << "}";
+      }
+      out_ << "}";
+    }
+  }
+  out_ << "\n]}" << std::endl;
+}
+
+#endif /* TRACE_HPP */